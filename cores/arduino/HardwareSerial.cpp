@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include "Arduino.h"
 #include "HardwareSerial.h"
+#include "HardwareTimer.h"
 //#if defined(HAVE_HWSERIAL) || defined(HAVE_HWSERIAL1) || defined(HAVE_HWSERIAL2) || defined(HAVE_HWSERIAL3)
 
 // SerialEvent functions are weak, so when the user doesn't define them,
@@ -42,8 +43,9 @@ int HardwareSerial::availableSerialN(unsigned n)
     if (n >= UART_NUM)
         return 0;
     auto _serial = obj_s_buf[n];
-    return ((unsigned int)(SERIAL_RX_BUFFER_SIZE + _serial->rx_head - _serial->rx_tail)) %
-           SERIAL_RX_BUFFER_SIZE;
+    if (_serial == NULL)
+        return 0;
+    return (uint16_t)(serial_rx_head(_serial) - _serial->rx_tail);
 }
 
 #if defined(HAVE_HWSERIAL1)
@@ -71,7 +73,6 @@ bool Serial3_available()
 #endif
 
 #if defined(HAVE_HWSERIAL4)
-HardwareSerial Serial4(RX3, TX3, 3);
 void serialEvent4() __attribute__((weak));
 bool Serial4_available()
 {
@@ -80,7 +81,6 @@ bool Serial4_available()
 #endif
 
 #if defined(HAVE_HWSERIAL5)
-HardwareSerial Serial5(RX4, TX4, 4);
 void serialEvent5() __attribute__((weak));
 bool Serial5_available()
 {
@@ -88,48 +88,190 @@ bool Serial5_available()
 }
 #endif
 
+// Ports that received bytes since their serialEvent last ran, bit n for
+// Serial(n + 1). Only maintained outside SERIAL_EVENT_POLL mode.
+static volatile uint32_t serial_event_pending;
+static uint8_t serial_event_mode = SERIAL_EVENT_POLL;
 
-void serialEventRun(void)
+void serialEventMode(uint8_t mode)
+{
+    serial_event_pending = 0;
+#if defined(SERIAL_EVENT_PENDSV)
+    // lowest priority, so serialEventN() never delays another interrupt
+    NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+#endif
+    serial_event_mode = mode;
+}
+
+static uint32_t serial_event_take(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t pending;
+
+    __disable_irq();
+    pending = serial_event_pending;
+    serial_event_pending = 0;
+    __set_PRIMASK(primask);
+    return pending;
+}
+
+static void serial_event_dispatch(uint32_t pending)
 {
 #if defined(HAVE_HWSERIAL1)
-    if (serialEvent1 && Serial1_available()) {
+    if ((pending & 0x01) && serialEvent1 && Serial1_available()) {
         serialEvent1();
     }
 #endif
 #if defined(HAVE_HWSERIAL2)
-    if (serialEvent2 && Serial2_available()) {
+    if ((pending & 0x02) && serialEvent2 && Serial2_available()) {
         serialEvent2();
     }
 #endif
 #if defined(HAVE_HWSERIAL3)
-    if (serialEvent3 && Serial3_available()) {
+    if ((pending & 0x04) && serialEvent3 && Serial3_available()) {
         serialEvent3();
     }
 #endif
 #if defined(HAVE_HWSERIAL4)
-    if (serialEvent4 && Serial4_available()) {
+    if ((pending & 0x08) && serialEvent4 && Serial4_available()) {
         serialEvent4();
     }
 #endif
 #if defined(HAVE_HWSERIAL5)
-    if(serialEvent5 && Serial5_available()) {
+    if ((pending & 0x10) && serialEvent5 && Serial5_available()) {
         serialEvent5();
     }
 #endif
 }
 
+void serialEventRun(void)
+{
+    if (serial_event_mode == SERIAL_EVENT_POLL) {
+        serial_event_dispatch(0xFFFFFFFFUL);
+        return;
+    }
+#if !defined(SERIAL_EVENT_PENDSV)
+    uint32_t pending = serial_event_take();
+    if (pending == 0) {
+        return;
+    }
+    serial_event_dispatch(pending);
+    // bytes left unread get their serialEvent again on the next pass, as in
+    // SERIAL_EVENT_POLL mode
+    for (unsigned n = 0; n < UART_NUM; n++) {
+        if ((pending & (1UL << n)) && HardwareSerial::availableSerialN(n) > 0) {
+            __disable_irq();
+            serial_event_pending |= 1UL << n;
+            __enable_irq();
+        }
+    }
+#endif
+}
+
+#if defined(SERIAL_EVENT_PENDSV)
+// Built with SERIAL_EVENT_PENDSV, SERIAL_EVENT_PENDING mode runs serialEventN()
+// from PendSV instead of loop(). Not for use with an RTOS that owns PendSV.
+extern "C" void PendSV_Handler(void)
+{
+    serial_event_dispatch(serial_event_take());
+}
+#endif
+
+void HardwareSerial::_rx_event_irq(serial_t *obj)
+{
+    if (obj->receive_callback != NULL) {
+        obj->receive_callback();
+    }
+    if (serial_event_mode == SERIAL_EVENT_POLL) {
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    serial_event_pending |= 1UL << obj->index;
+    __set_PRIMASK(primask);
+#if defined(SERIAL_EVENT_PENDSV)
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+}
+
 HardwareSerial::HardwareSerial(uint8_t rx, uint8_t tx, int uart_index)
+    : HardwareSerial(rx, tx, uart_index, new unsigned char[SERIAL_RX_BUFFER_SIZE], SERIAL_RX_BUFFER_SIZE,
+                     new unsigned char[SERIAL_TX_BUFFER_SIZE], SERIAL_TX_BUFFER_SIZE)
 {
+    _own_rx = _serial.rx_buff;
+    _own_tx = _serial.tx_buff;
+}
+
+HardwareSerial::HardwareSerial(uint8_t rx, uint8_t tx, int uart_index,
+                               unsigned char *rx_buffer, uint16_t rx_size,
+                               unsigned char *tx_buffer, uint16_t tx_size)
+{
+    _own_rx = NULL;
+    _own_tx = NULL;
     _serial.pin_rx = DIGITAL_TO_PINNAME(rx);
     _serial.pin_tx =  DIGITAL_TO_PINNAME(tx);
-    _serial.rx_buff = _rx_buffer;
+    _serial.rx_buff = rx_buffer;
+    _serial.rx_buff_size = serial_ring_t::fit(rx_size);
     _serial.rx_head = 0;
     _serial.rx_tail = 0;
-    _serial.tx_buff = _tx_buffer;
+    _serial.tx_buff = tx_buffer;
+    _serial.tx_buff_size = serial_ring_t::fit(tx_size);
     _serial.tx_head = 0;
     _serial.tx_tail = 0;
     _serial.tx_count = 0;
     _serial.index = uart_index;
+    _serial.rx_dma = 0;
+    _serial.tx_dma = 0;
+    _dma_mode = 0;
+    _tx_policy = SERIAL_TX_BLOCK;
+    _multidrop = false;
+    _begun = false;
+    _serial.char_match = SERIAL_RESERVED_CHAR_MATCH;
+    _serial.match_callback = NULL;
+    _serial.idle_callback = NULL;
+    _serial.receive_callback = NULL;
+    _serial.de_pin = NC;
+    _serial.rts_pin = NC;
+    _serial.cts_pin = NC;
+    _serial.rts_hw = 0;
+    _serial.rts_held = 0;
+    _rts_pin = NC;
+    _cts_pin = NC;
+    _serial.frame_mode = SERIAL_FRAME_OFF;
+    _serial.frame_head = 0;
+    _serial.frame_tail = 0;
+    _serial.frame_last = 0;
+    _frame_chars10 = 0;
+    _frame_timer = NULL;
+    memset(&_serial.stats, 0, sizeof(_serial.stats));
+}
+
+HardwareSerial::~HardwareSerial()
+{
+    delete[] _own_rx;
+    delete[] _own_tx;
+}
+
+void HardwareSerial::setBuffers(unsigned char *rx_buffer, uint16_t rx_size,
+                                unsigned char *tx_buffer, uint16_t tx_size)
+{
+    // a ring of size n holds n - 1 bytes
+    if (_begun || (rx_buffer == NULL) || (rx_size < 2) || (tx_buffer == NULL) || (tx_size < 2)) {
+        return;
+    }
+    _serial.rx_buff = rx_buffer;
+    _serial.rx_buff_size = serial_ring_t::fit(rx_size);
+    _serial.rx_head = 0;
+    _serial.rx_tail = 0;
+    _serial.tx_buff = tx_buffer;
+    _serial.tx_buff_size = serial_ring_t::fit(tx_size);
+    _serial.tx_head = 0;
+    _serial.tx_tail = 0;
+    // heap rings of the three argument constructor are not needed any more
+    delete[] _own_rx;
+    delete[] _own_tx;
+    _own_rx = NULL;
+    _own_tx = NULL;
 }
 
 void HardwareSerial::begin(unsigned long baud, uint8_t config)
@@ -166,63 +308,230 @@ void HardwareSerial::begin(unsigned long baud, uint8_t config)
         stopbits = 1;
     }
 
+    _multidrop = false;
     serial_init(&_serial, _serial.pin_tx, _serial.pin_rx);
     serial_baud(&_serial, baud);
     serial_format(&_serial, databits, parity, stopbits);
+    serial_flow_control(&_serial, _rts_pin, _cts_pin);
 
-    uart_attach_rx_callback(&_serial, _rx_complete_irq);
-    serial_receive(&_serial, &_serial.rx_buff[_serial.rx_head], 1);
+    _serial.rx_head = 0;
+    _serial.rx_tail = 0;
+    if ((_dma_mode & SERIAL_DMA_RX) && serial_rx_dma_start(&_serial, _serial.rx_buff_size)) {
+        // the DMA channel fills the ring, no per-byte interrupt needed
+        uart_attach_rx_callback(&_serial, _rx_event_irq);
+    } else {
+        uart_attach_rx_callback(&_serial, _rx_complete_irq);
+        serial_receive(&_serial, &_serial.rx_buff[0], 1);
+    }
+    _serial.rx_match = 0;
+    serial_idle_notify(&_serial, _serial.idle_callback);
+    _frame_setup();
+    if ((_dma_mode & SERIAL_DMA_TX) && serial_tx_dma_start(&_serial)) {
+        uart_attach_tx_callback(&_serial, _tx_complete_irq);
+    }
     // only enable it after everything has been setup properly
     serial_enable(&_serial);
+    _begun = true;
+}
+
+unsigned long HardwareSerial::beginAutoBaud(uint8_t config, uint32_t timeout)
+{
+    unsigned long baud;
+
+    // the starting rate only matters if nothing is detected
+    begin(9600, config);
+    baud = serial_autobaud(&_serial, timeout);
+    if (baud == 0) {
+        return 0;
+    }
+    // let the rest of the measured character pass and drop what the USART
+    // made of it
+    delay(1 + serial_char_bits(&_serial) * 1000 / baud);
+    _serial.rx_tail = serial_rx_head(&_serial);
+    _frame_setup();
+    return baud;
+}
+
+void HardwareSerial::beginMultiDrop(unsigned long baud, uint8_t address)
+{
+    // 8-bit DMA writes would land in the address bit as well
+    uint8_t mode = _dma_mode;
+
+    _dma_mode &= ~SERIAL_DMA_TX;
+    begin(baud, SERIAL_8N1);
+    _dma_mode = mode;
+    serial_multidrop(&_serial, address);
+    _multidrop = true;
+    // 9-bit words are longer
+    _frame_setup();
+}
+
+void HardwareSerial::writeAddress(uint8_t address)
+{
+    if (!_multidrop) {
+        return;
+    }
+    flush();
+    serial_send_address(&_serial, address);
+}
+
+void HardwareSerial::mute(void)
+{
+    if (_multidrop) {
+        serial_mute(&_serial);
+    }
+}
+
+void HardwareSerial::clearStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(&_serial.stats, 0, sizeof(_serial.stats));
+    __set_PRIMASK(primask);
+}
+
+// Timers that end frames on the USARTs without a receiver timeout
+static HardwareTimer *frame_timer[UART_NUM];
+
+template <unsigned n>
+static void frame_timer_irq(void)
+{
+    if (n < UART_NUM) {
+        frame_timer[n]->stop();
+        serial_frame_end(obj_s_buf[n]);
+    }
+}
+
+static const timerCallback_t frame_timer_irqs[] = {
+    frame_timer_irq<0>, frame_timer_irq<1>, frame_timer_irq<2>, frame_timer_irq<3>, frame_timer_irq<4>
+};
+
+void HardwareSerial::enableFrames(uint16_t charTimes10, HardwareTimer *timer)
+{
+    _frame_chars10 = charTimes10 ? charTimes10 : 1;
+    _frame_timer = timer;
+    _frame_setup();
+}
+
+void HardwareSerial::disableFrames(void)
+{
+    _frame_chars10 = 0;
+    _frame_setup();
+}
+
+void HardwareSerial::_frame_setup(void)
+{
+    uint8_t mode;
+
+    if (frame_timer[_serial.index] != NULL) {
+        frame_timer[_serial.index]->stop();
+        frame_timer[_serial.index]->detachInterrupt();
+        frame_timer[_serial.index] = NULL;
+    }
+    if (_frame_chars10 == 0) {
+        serial_frame_stop(&_serial);
+        return;
+    }
+
+    // a timer needs the per byte interrupt to be restarted
+    mode = serial_frame_start(&_serial, _frame_chars10,
+                              ((_frame_timer != NULL) && !_serial.rx_dma) ? SERIAL_FRAME_EXT : SERIAL_FRAME_IDLE);
+    if ((mode == SERIAL_FRAME_EXT) && (_serial.baudrate != 0)) {
+        uint32_t us = (uint64_t)serial_char_bits(&_serial) * _frame_chars10 * 100000 / _serial.baudrate;
+        _frame_timer->stop();
+        _frame_timer->setPeriodTime(us ? us : 1, FORMAT_US);
+        _frame_timer->attachInterrupt(frame_timer_irqs[_serial.index]);
+        frame_timer[_serial.index] = _frame_timer;
+    }
+}
+
+int HardwareSerial::availableFrame(void)
+{
+    while (_serial.frame_tail != _serial.frame_head) {
+        uint16_t end = _serial.frame_end[_serial.frame_tail & (SERIAL_FRAME_QUEUE_SIZE - 1)];
+        if ((int16_t)(end - _serial.rx_tail) > 0) {
+            return (uint16_t)(end - _serial.rx_tail);
+        }
+        // already taken through read()
+        _serial.frame_tail++;
+    }
+    return 0;
+}
+
+size_t HardwareSerial::readFrame(uint8_t *buffer, size_t size)
+{
+    size_t len = availableFrame();
+    size_t copied = 0;
+    uint16_t end = _serial.rx_tail + len;
+    serial_ring_t rx(_serial.rx_buff, _serial.rx_buff_size, end, _serial.rx_tail);
+
+    if (len == 0) {
+        return 0;
+    }
+    if (size > len) {
+        size = len;
+    }
+    while (copied < size) {
+        const uint8_t *span;
+        size_t count = rx.readSpan(&span);
+        if (count > size - copied) {
+            count = size - copied;
+        }
+        memcpy(buffer + copied, span, count);
+        rx.consume(count);
+        copied += count;
+    }
+    // drop what did not fit along with the frame
+    rx.consume(end - _serial.rx_tail);
+    _serial.frame_tail++;
+    if (_serial.rts_held) {
+        serial_rts_update(&_serial);
+    }
+    return copied;
 }
 
 void HardwareSerial::end()
 {
     //clear any received data
-    _serial.rx_head  = _serial.rx_tail;
+    _serial.rx_tail = serial_rx_head(&_serial);
     //wait for any outstanding data to be sent
     flush();
     //disable the USART
     serial_free(&_serial);
+    _begun = false;
 }
 
 int HardwareSerial::available(void)
 {
-    return ((unsigned int)(SERIAL_RX_BUFFER_SIZE + _serial.rx_head - _serial.rx_tail)) %
-           SERIAL_RX_BUFFER_SIZE;
+    return (uint16_t)(serial_rx_head(&_serial) - _serial.rx_tail);
 }
 int HardwareSerial::peek(void)
 {
-    if (_serial.rx_head  == _serial.rx_tail) {
-        return -1;
-    } else {
-        return _serial.rx_buff[_serial.rx_tail];
-    }
+    uint16_t head = serial_rx_head(&_serial);
+    serial_ring_t rx(_serial.rx_buff, _serial.rx_buff_size, head, _serial.rx_tail);
+
+    return rx.peek();
 }
 
 int HardwareSerial::read(void)
 {
-    unsigned char c;
+    uint16_t head = serial_rx_head(&_serial);
+    serial_ring_t rx(_serial.rx_buff, _serial.rx_buff_size, head, _serial.rx_tail);
 
-    // if the head isn't ahead of the tail, we don't have any characters
-    if (_serial.rx_head  == _serial.rx_tail) {
-        return -1;
-    } else {
-        c = _serial.rx_buff[_serial.rx_tail];
-        _serial.rx_tail = (rx_buffer_index_t)(_serial.rx_tail + 1) % SERIAL_RX_BUFFER_SIZE;
-        return c;
+    // -1 if the head isn't ahead of the tail
+    int c = rx.pop();
+    if (_serial.rts_held) {
+        serial_rts_update(&_serial);
     }
+    return c;
 }
 
 int HardwareSerial::availableForWrite(void)
 {
-    tx_buffer_index_t head = _serial.tx_head;
-    tx_buffer_index_t tail = _serial.tx_tail;
+    serial_ring_t tx(_serial.tx_buff, _serial.tx_buff_size, _serial.tx_head, _serial.tx_tail);
 
-    if (head >= tail) {
-        return SERIAL_TX_BUFFER_SIZE - 1 - head + tail;
-    }
-    return tail - head - 1;
+    return tx.availableForWrite();
 }
 
 void HardwareSerial::flush()
@@ -239,25 +548,164 @@ void HardwareSerial::flush()
     }
     // Wait for transmission to complete
     while ((_serial.tx_state & OP_STATE_BUSY) != 0);
+    // DMA spans are retired before their last frames have been shifted out
+    while (_serial.tx_dma && !serial_tx_complete(&_serial));
 }
 
 size_t HardwareSerial::write(uint8_t c)
 {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    serial_ring_t tx(_serial.tx_buff, _serial.tx_buff_size, _serial.tx_head, _serial.tx_tail);
+    size_t written = 0;
+
+    while (written < size) {
+        uint8_t *span;
+        size_t room = tx.writeSpan(&span);
+        if (room == 0) {
+            if (_tx_policy == SERIAL_TX_BLOCK) {
+                continue;   // Spin until the running transmission frees some space
+            }
+            // nothing left to discard when the whole ring is already on the wire
+            if ((_tx_policy == SERIAL_TX_FAIL_FAST) || (_tx_drop_oldest(size - written) == 0)) {
+                _serial.stats.tx_dropped += size - written;
+                break;
+            }
+            continue;
+        }
+        if (room > size - written) {
+            room = size - written;
+        }
+        memcpy(span, buffer + written, room);
+        commit(room);
+        written += room;
+    }
+    return written;
+}
+
+size_t HardwareSerial::readSpan(const uint8_t **p)
+{
+    uint16_t head = serial_rx_head(&_serial);
+    serial_ring_t rx(_serial.rx_buff, _serial.rx_buff_size, head, _serial.rx_tail);
+
+    return rx.readSpan(p);
+}
+
+void HardwareSerial::consume(size_t n)
+{
+    uint16_t head = serial_rx_head(&_serial);
+    serial_ring_t rx(_serial.rx_buff, _serial.rx_buff_size, head, _serial.rx_tail);
+
+    if (n > rx.available()) {
+        n = rx.available();
+    }
+    rx.consume(n);
+    if (_serial.rts_held) {
+        serial_rts_update(&_serial);
+    }
+}
+
+size_t HardwareSerial::writeSpan(uint8_t **p)
+{
+    serial_ring_t tx(_serial.tx_buff, _serial.tx_buff_size, _serial.tx_head, _serial.tx_tail);
+
+    return tx.writeSpan(p);
+}
+
+void HardwareSerial::commit(size_t n)
+{
+    serial_ring_t tx(_serial.tx_buff, _serial.tx_buff_size, _serial.tx_head, _serial.tx_tail);
+
+    if (n > tx.availableForWrite()) {
+        n = tx.availableForWrite();
+    }
+    if (n == 0) {
+        return;
+    }
     _written = true;
-    tx_buffer_index_t nextWrite = (_serial.tx_head + 1) % SERIAL_TX_BUFFER_SIZE;
-    while (_serial.tx_tail == nextWrite) {
-    }   // Spin locks if we're about to overwrite the buffer. This continues once the data is sent
-    _serial.tx_buff[_serial.tx_head] = c;
-    _serial.tx_head = nextWrite;
+    tx.commit(n);
+    if (tx.available() > _serial.stats.tx_peak) {
+        _serial.stats.tx_peak = tx.available();
+    }
 
-    _serial.tx_count++;
+    _tx_start();
+}
 
+// Hand the TX ring to the DMA channel or the TX interrupt unless it is busy
+void HardwareSerial::_tx_start(void)
+{
+    if (_serial.tx_dma) {
+        _tx_dma_kick();
+        return;
+    }
     if (!serial_tx_active(&_serial)) {
         uart_attach_tx_callback(&_serial, _tx_complete_irq);
-        serial_transmit(&_serial, &_serial.tx_buff[_serial.tx_tail], 1);
+        serial_transmit(&_serial, &_serial.tx_buff[_serial.tx_tail & (_serial.tx_buff_size - 1)], 1);
+    }
+}
 
+// Make room for want bytes by discarding exactly that many of the oldest bytes
+// that have not been handed to the UART or the DMA channel yet. With nothing
+// in flight the tail simply moves on. Otherwise the bytes queued behind the
+// discarded ones are moved down onto them. They are taken out of the ring
+// first, so the copy runs with interrupts on while the transmitter finishes
+// the span it owns.
+size_t HardwareSerial::_tx_drop_oldest(size_t want)
+{
+    uint16_t mask = _serial.tx_buff_size - 1;
+    uint16_t start, queued, keep, drop;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    start = _serial.tx_tail;
+    if (serial_tx_active(&_serial)) {
+        start += _serial.tx_dma ? _serial.tx_count : 1;
+    }
+    queued = _serial.tx_head - start;
+    drop = (queued > want) ? (uint16_t)want : queued;
+    keep = queued - drop;
+    _serial.stats.tx_dropped += drop;
+    if ((drop == 0) || (start == _serial.tx_tail)) {
+        _serial.tx_tail += drop;
+        __set_PRIMASK(primask);
+        return drop;
     }
-    return 1;
+    _serial.tx_head = start;
+    __set_PRIMASK(primask);
+
+    for (uint16_t i = 0; i < keep; i++) {
+        _serial.tx_buff[(uint16_t)(start + i) & mask] = _serial.tx_buff[(uint16_t)(start + drop + i) & mask];
+    }
+    _serial.tx_head = start + keep;
+    _tx_start();
+
+    return drop;
+}
+
+// Start the next DMA span unless one is already running. The DMA interrupt
+// may chain spans concurrently, so do the check and the start atomically.
+void HardwareSerial::_tx_dma_kick(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    _tx_dma_span(&_serial);
+    __set_PRIMASK(primask);
+}
+
+// Send the contiguous part of the TX ring that starts at the tail
+void HardwareSerial::_tx_dma_span(serial_t *obj)
+{
+    serial_ring_t tx(obj->tx_buff, obj->tx_buff_size, obj->tx_head, obj->tx_tail);
+    const uint8_t *span;
+    uint16_t count = tx.readSpan(&span);
+
+    if ((count == 0) || serial_tx_active(obj)) {
+        return;
+    }
+    serial_tx_dma_transmit(obj, span, count);
 }
 
 void HardwareSerial::_rx_complete_irq(serial_t *obj)
@@ -270,13 +718,27 @@ void HardwareSerial::_rx_complete_irq(serial_t *obj)
     if (serial_rx_active(obj)) {
         return;
     }
+    serial_ring_t rx(obj->rx_buff, obj->rx_buff_size, obj->rx_head, obj->rx_tail);
     c = serial_getc(obj);
-    rx_buffer_index_t i = (unsigned int)(obj->rx_head + 1) % SERIAL_RX_BUFFER_SIZE;
-    if (i != obj->rx_tail) {
-        obj->rx_buff[obj->rx_head] = c;
-        obj->rx_head = i;
+    obj->stats.rx_bytes++;
+    if (!rx.push(c)) {
+        obj->stats.rx_overflow++;
+    } else if (rx.available() > obj->stats.rx_peak) {
+        obj->stats.rx_peak = rx.available();
+    }
+    if (obj->rts_pin != NC) {
+        serial_rts_update(obj);
+    }
+    if ((obj->match_callback != NULL) && (c == obj->char_match)) {
+        obj->match_callback();
     }
-    serial_receive(obj, &obj->rx_buff[obj->rx_head], 1);
+    if ((obj->frame_mode == SERIAL_FRAME_EXT) && (frame_timer[obj->index] != NULL)) {
+        // restart the silence measurement
+        frame_timer[obj->index]->setCounter(1);
+        frame_timer[obj->index]->start();
+    }
+    _rx_event_irq(obj);
+    serial_receive(obj, &obj->rx_buff[obj->rx_head & (obj->rx_buff_size - 1)], 1);
 }
 
 void HardwareSerial::_tx_complete_irq(serial_t *obj)
@@ -284,41 +746,18 @@ void HardwareSerial::_tx_complete_irq(serial_t *obj)
     if (obj == NULL) {
         return;
     }
-    obj->tx_tail = (obj->tx_tail + 1) % SERIAL_TX_BUFFER_SIZE;
-    if (obj->tx_head == obj->tx_tail) {
-    } else {
-        serial_transmit(obj, &obj->tx_buff[obj->tx_tail], 1);
+    serial_ring_t tx(obj->tx_buff, obj->tx_buff_size, obj->tx_head, obj->tx_tail);
+    if (obj->tx_dma) {
+        // retire the span that just went out and chain the next one
+        tx.consume(obj->tx_count);
+        obj->stats.tx_bytes += obj->tx_count;
+        _tx_dma_span(obj);
+        return;
+    }
+    const uint8_t *span;
+    tx.consume(1);
+    obj->stats.tx_bytes++;
+    if (tx.readSpan(&span) != 0) {
+        serial_transmit(obj, span, 1);
     }
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -28,19 +28,18 @@
 
 #include "api/Stream.h"
 #include "uart.h"
+#include "SerialRing.h"
 
 
-// Define constants and variables for buffering incoming serial data.  We're
-// using a ring buffer (I think), in which head is the index of the location
-// to which to write the next incoming character and tail is the index of the
-// location from which to read.
-// NOTE: a "power of 2" buffer size is reccomended to dramatically
-//       optimize all the modulo operations for ring buffers.
-// WARNING: When buffer sizes are increased to > 256, the buffer index
-// variables are automatically increased in size, but the extra
-// atomicity guards needed for that are not implemented. This will
-// often work, but occasionally a race condition can occur that makes
-// Serial behave erratically. See https://github.com/arduino/Arduino/issues/2405
+// Define constants and variables for buffering incoming serial data. The
+// RX and TX rings are SerialRing views on storage and indices kept in
+// serial_t: head is where the next byte is written, tail where the next byte
+// is read. The indices run freely and are masked on access, so ring sizes
+// are powers of two; a size in between is rounded down to the next power of
+// two and a ring of size n holds n - 1 bytes.
+// SERIAL_RX_BUFFER_SIZE / SERIAL_TX_BUFFER_SIZE are the defaults. Each of
+// Serial1..Serial5 can be sized on its own with SERIALn_RX_BUFFER_SIZE /
+// SERIALn_TX_BUFFER_SIZE, or given user storage with setBuffers().
 
 #if !defined(SERIAL_TX_BUFFER_SIZE)
 #define SERIAL_TX_BUFFER_SIZE 64
@@ -48,29 +47,10 @@
 #if !defined(SERIAL_RX_BUFFER_SIZE)
 #define SERIAL_RX_BUFFER_SIZE 64
 #endif
-#if (SERIAL_TX_BUFFER_SIZE>256)
-typedef uint16_t tx_buffer_index_t;
-#else
-typedef uint8_t tx_buffer_index_t;
-#endif
-#if  (SERIAL_RX_BUFFER_SIZE>256)
-typedef uint16_t rx_buffer_index_t;
-#else
-typedef uint8_t rx_buffer_index_t;
-#endif
-
 
-typedef struct {
-    unsigned char buffer[SERIAL_RX_BUFFER_SIZE];
-    volatile int head;
-    volatile int tail;
-} ring_buffer_r;
+typedef SerialRing<uint16_t> serial_ring_t;
 
-typedef struct {
-    unsigned char buffer[SERIAL_TX_BUFFER_SIZE];
-    volatile int head;
-    volatile int tail;
-} ring_buffer_t;
+class HardwareTimer;
 
 #define SERIAL_8N1 0x06
 #define SERIAL_8N2 0x0E
@@ -83,26 +63,160 @@ typedef struct {
 #define SERIAL_7O2 0x3C
 #define SERIAL_8O2 0x3E
 
+// DMA modes for HardwareSerial::enableDMA()
+#define SERIAL_DMA_RX 0x01
+#define SERIAL_DMA_TX 0x02
+
+// What write() does when the TX ring is full, see HardwareSerial::setTxPolicy()
+#define SERIAL_TX_BLOCK       0   // wait until the UART drains enough bytes
+#define SERIAL_TX_FAIL_FAST   1   // return at once, bytes that do not fit are dropped
+#define SERIAL_TX_DROP_OLDEST 2   // discard the oldest bytes still waiting in the ring
+
+// How serialEventRun() finds the ports to call serialEventN() for, see serialEventMode()
+#define SERIAL_EVENT_POLL    0   // ask every port after each loop() pass
+#define SERIAL_EVENT_PENDING 1   // the RX interrupt flags its port, one check per pass
+
 class HardwareSerial : public Stream
 {
     protected:
         // Has any byte been written to the UART since begin()
         volatile bool _written;
-        // Don't put any members after these buffers, since only the first
-        // 32 bytes of this struct can be accessed quickly using the ldd
-        // instruction.
-        unsigned char _rx_buffer[SERIAL_RX_BUFFER_SIZE];
-        unsigned char _tx_buffer[SERIAL_TX_BUFFER_SIZE];
+        // SERIAL_DMA_* modes requested through enableDMA()
+        uint8_t _dma_mode;
+        // SERIAL_TX_* overflow policy
+        uint8_t _tx_policy;
+        // Joined a multi-drop bus through beginMultiDrop()
+        bool _multidrop;
+        // Between begin() and end()
+        bool _begun;
+        // Frame mode silence in tenths of a character time, 0 when off
+        uint16_t _frame_chars10;
+        HardwareTimer *_frame_timer;
+        // Flow control pins requested through setFlowControl()
+        PinName _rts_pin;
+        PinName _cts_pin;
+        // Ring storage allocated by the three argument constructor
+        unsigned char *_own_rx;
+        unsigned char *_own_tx;
         serial_t _serial;
 
     public:
+        // Rings of SERIAL_RX_BUFFER_SIZE / SERIAL_TX_BUFFER_SIZE bytes taken from
+        // the heap, use HardwareSerialT or the constructor below to avoid that
         HardwareSerial(uint8_t rx, uint8_t tx, int uart_index);
+        HardwareSerial(uint8_t rx, uint8_t tx, int uart_index,
+                       unsigned char *rx_buffer, uint16_t rx_size,
+                       unsigned char *tx_buffer, uint16_t tx_size);
+        ~HardwareSerial();
+        // A copy would free the heap rings a second time
+        HardwareSerial(const HardwareSerial &) = delete;
+        HardwareSerial &operator=(const HardwareSerial &) = delete;
         void begin(unsigned long baud)
         {
             begin(baud, SERIAL_8N1);
         }
         void begin(unsigned long, uint8_t);
+        // begin() at the rate of the first character received within timeout
+        // ms, returns that rate or 0. Send an odd character such as 'U' or CR
+        // from the other side, the character itself is discarded.
+        unsigned long beginAutoBaud(uint8_t config = SERIAL_8N1, uint32_t timeout = 1000);
+        // Join a 9-bit multi-drop bus as node address. The USART drops all
+        // traffic, without RX interrupts, until an address mark for this node
+        // arrives and goes mute again on the next mark for another node.
+        // address has 4 bits on GD32F10x/F30x/E50x, 8 bits elsewhere.
+        // Transmission does not use DMA in this mode.
+        void beginMultiDrop(unsigned long baud, uint8_t address);
+        // Send an address mark once the pending bytes are out, the bytes
+        // written after it go to that node
+        void writeAddress(uint8_t address);
+        // Ignore the bus until the next address mark for this node
+        void mute(void);
         void end();
+        // Replace the RX/TX ring storage, call before begin(). Ignored while
+        // the port is running, the DMA channel may still write the old ring.
+        void setBuffers(unsigned char *rx_buffer, uint16_t rx_size,
+                        unsigned char *tx_buffer, uint16_t tx_size);
+        // Select SERIAL_DMA_* modes, takes effect on the next begin().
+        // Falls back to interrupt mode when the DMA channel is not available.
+        void enableDMA(uint8_t mode)
+        {
+            _dma_mode = mode;
+        }
+        // Select the SERIAL_TX_* policy for a full TX ring, SERIAL_TX_BLOCK by default
+        void setTxPolicy(uint8_t policy)
+        {
+            _tx_policy = policy;
+        }
+        // Bytes dropped by SERIAL_TX_FAIL_FAST / SERIAL_TX_DROP_OLDEST
+        uint32_t txDropped(void)
+        {
+            return _serial.stats.tx_dropped;
+        }
+        // Byte, overflow, error and peak occupancy counters of this port
+        serial_stats_t stats(void)
+        {
+            return _serial.stats;
+        }
+        void clearStats(void);
+        // Call callback from the UART interrupt each time c has been received,
+        // e.g. onDelimiter('\n', lineReady). With DMA reception the matches are
+        // seen on the next half/full transfer or idle line, one call for each.
+        // Passing NULL disables it.
+        void onDelimiter(char c, void (*callback)(void))
+        {
+            serial_char_match(&_serial, (uint8_t)c, callback);
+        }
+        // Call callback from the UART interrupt when the RX line goes idle
+        // after a frame. Passing NULL disables it.
+        void onFrame(void (*callback)(void))
+        {
+            serial_idle_notify(&_serial, callback);
+        }
+        // Call callback from the UART interrupt whenever bytes have been added
+        // to the receive ring: after each byte, or with DMA reception on half
+        // and full transfer and idle line. Passing NULL disables it. The USART
+        // and its DMA channels share one interrupt priority, so the callback
+        // is never reentered and may take the bytes with readSpan()/consume().
+        void onReceive(void (*callback)(void))
+        {
+            _serial.receive_callback = callback;
+        }
+        // Drive an RS-485 transceiver: dePin goes to polarity before the first
+        // byte and back in the transmit complete interrupt, no flush() needed.
+        void setRS485(uint32_t dePin, PinStatus polarity = HIGH)
+        {
+            serial_rs485(&_serial, DIGITAL_TO_PINNAME(dePin), polarity);
+        }
+        void noRS485(void)
+        {
+            serial_rs485(&_serial, NC, 0);
+        }
+        // RTS/CTS flow control, call before begin(). cts must be the USART's
+        // CTS pin. rts may be any pin, it is dropped by the USART while a byte
+        // waits in the receive register (when it is the USART's RTS pin) and
+        // by the RX path while the ring is above three quarters full. Pass NC
+        // for a line that is not used.
+        void setFlowControl(uint32_t rtsPin, uint32_t ctsPin)
+        {
+            _rts_pin = DIGITAL_TO_PINNAME(rtsPin);
+            _cts_pin = DIGITAL_TO_PINNAME(ctsPin);
+        }
+        void noFlowControl(void)
+        {
+            _rts_pin = NC;
+            _cts_pin = NC;
+        }
+        // Frame mode: bytes are grouped into frames that end after a silence of
+        // charTimes10 / 10 character times, 35 for Modbus RTU. The USART
+        // receiver timeout measures it where there is one. Elsewhere timer is
+        // restarted by every byte, and without a timer (or with DMA reception)
+        // a frame ends on idle line, after one character time.
+        void enableFrames(uint16_t charTimes10 = 35, HardwareTimer *timer = NULL);
+        void disableFrames(void);
+        // Length of the oldest complete frame, 0 if there is none
+        int availableFrame(void);
+        // Read the oldest complete frame, bytes beyond size are discarded
+        size_t readFrame(uint8_t *buffer, size_t size);
         virtual int available(void);
         virtual int peek(void);
         virtual int read(void);
@@ -125,7 +239,29 @@ class HardwareSerial : public Stream
         {
             return write((uint8_t)n);
         }
+        virtual size_t write(const uint8_t *buffer, size_t size);
         using Print::write; // pull in write(str) and write(buf, size) from Print
+
+        // Zero-copy access to the rings. readSpan() points p at the largest
+        // contiguous block of received bytes and returns its length, consume()
+        // releases n of them. writeSpan() points p at the largest contiguous
+        // free block of the TX ring, commit() sends n bytes written there.
+        //
+        // A span stays valid until the matching consume() or commit(): the
+        // receive interrupt or DMA only appends after the bytes of a read
+        // span, and the transmitter only reads bytes committed before a write
+        // span. Where the ring wraps, the span ends at the end of the buffer
+        // and a second call after consume()/commit() returns the rest from
+        // the start. consume() and commit() clamp n to the bytes held or free.
+        // Like read() and write(), the calls belong to one consumer and one
+        // producer, and must not be mixed with read(), write() or a second
+        // span on the same ring while one is open. The consumer is either the
+        // sketch or the onReceive() callback, never both; no other interrupt
+        // may use them.
+        size_t readSpan(const uint8_t **p);
+        void consume(size_t n);
+        size_t writeSpan(uint8_t **p);
+        void commit(size_t n);
         operator bool()
         {
             return true;
@@ -134,12 +270,35 @@ class HardwareSerial : public Stream
         // Interrupt handlers
         static void _rx_complete_irq(serial_t *obj);
         static void _tx_complete_irq(serial_t *obj);
+        static void _tx_dma_span(serial_t *obj);
+        static void _rx_event_irq(serial_t *obj);
 
         // helper func for linker
         static int availableSerialN(unsigned n);
 
     private:
+        void _tx_start(void);
+        void _tx_dma_kick(void);
+        size_t _tx_drop_oldest(size_t want);
+        void _frame_setup(void);
+};
 
+// A HardwareSerial carrying its own ring buffers of the given sizes, e.g.
+// HardwareSerialT<2048, 64> GpsSerial(PA3, PA2, 1);
+template <uint16_t RX_SIZE = SERIAL_RX_BUFFER_SIZE, uint16_t TX_SIZE = SERIAL_TX_BUFFER_SIZE>
+class HardwareSerialT : public HardwareSerial
+{
+    public:
+        HardwareSerialT(uint8_t rx, uint8_t tx, int uart_index)
+            : HardwareSerial(rx, tx, uart_index, _rx_storage, RX_SIZE, _tx_storage, TX_SIZE)
+        {
+        }
+
+    private:
+        static_assert((RX_SIZE & (RX_SIZE - 1)) == 0 && (TX_SIZE & (TX_SIZE - 1)) == 0,
+                      "serial ring sizes must be powers of two");
+        unsigned char _rx_storage[RX_SIZE];
+        unsigned char _tx_storage[TX_SIZE];
 };
 
 /*
@@ -189,4 +348,8 @@ extern HardwareSerial Serial5;
 #endif
 
 extern void serialEventRun(void) __attribute__((weak));
+// Select SERIAL_EVENT_POLL (the default) or SERIAL_EVENT_PENDING. Built with
+// -DSERIAL_EVENT_PENDSV, pending ports are served from the PendSV interrupt
+// right after the RX interrupt instead of after loop().
+extern void serialEventMode(uint8_t mode);
 #endif
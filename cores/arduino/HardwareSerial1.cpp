@@ -6,5 +6,17 @@
 // otherwise we pay the RAM for *all* serial objects.
 
 #if defined(HAVE_HWSERIAL1)
-HardwareSerial Serial1(RX0, TX0, 0);
+#if !defined(SERIAL1_RX_BUFFER_SIZE)
+#define SERIAL1_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL1_TX_BUFFER_SIZE)
+#define SERIAL1_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+
+static unsigned char serial1_rx_buffer[SERIAL1_RX_BUFFER_SIZE];
+static unsigned char serial1_tx_buffer[SERIAL1_TX_BUFFER_SIZE];
+
+HardwareSerial Serial1(RX0, TX0, 0,
+                       serial1_rx_buffer, SERIAL1_RX_BUFFER_SIZE,
+                       serial1_tx_buffer, SERIAL1_TX_BUFFER_SIZE);
 #endif
\ No newline at end of file
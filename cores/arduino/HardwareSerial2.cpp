@@ -6,5 +6,17 @@
 // otherwise we pay the RAM for *all* serial objects.
 
 #if defined(HAVE_HWSERIAL2)
-HardwareSerial Serial2(RX1, TX1, 1);
+#if !defined(SERIAL2_RX_BUFFER_SIZE)
+#define SERIAL2_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL2_TX_BUFFER_SIZE)
+#define SERIAL2_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+
+static unsigned char serial2_rx_buffer[SERIAL2_RX_BUFFER_SIZE];
+static unsigned char serial2_tx_buffer[SERIAL2_TX_BUFFER_SIZE];
+
+HardwareSerial Serial2(RX1, TX1, 1,
+                       serial2_rx_buffer, SERIAL2_RX_BUFFER_SIZE,
+                       serial2_tx_buffer, SERIAL2_TX_BUFFER_SIZE);
 #endif
\ No newline at end of file
@@ -6,5 +6,17 @@
 // otherwise we pay the RAM for *all* serial objects.
 
 #if defined(HAVE_HWSERIAL3)
-HardwareSerial Serial3(RX2, TX2, 2);
+#if !defined(SERIAL3_RX_BUFFER_SIZE)
+#define SERIAL3_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL3_TX_BUFFER_SIZE)
+#define SERIAL3_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+
+static unsigned char serial3_rx_buffer[SERIAL3_RX_BUFFER_SIZE];
+static unsigned char serial3_tx_buffer[SERIAL3_TX_BUFFER_SIZE];
+
+HardwareSerial Serial3(RX2, TX2, 2,
+                       serial3_rx_buffer, SERIAL3_RX_BUFFER_SIZE,
+                       serial3_tx_buffer, SERIAL3_TX_BUFFER_SIZE);
 #endif
\ No newline at end of file
@@ -6,5 +6,17 @@
 // otherwise we pay the RAM for *all* serial objects.
 
 #if defined(HAVE_HWSERIAL4)
-HardwareSerial Serial4(RX3, TX3, 3);
+#if !defined(SERIAL4_RX_BUFFER_SIZE)
+#define SERIAL4_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL4_TX_BUFFER_SIZE)
+#define SERIAL4_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+
+static unsigned char serial4_rx_buffer[SERIAL4_RX_BUFFER_SIZE];
+static unsigned char serial4_tx_buffer[SERIAL4_TX_BUFFER_SIZE];
+
+HardwareSerial Serial4(RX3, TX3, 3,
+                       serial4_rx_buffer, SERIAL4_RX_BUFFER_SIZE,
+                       serial4_tx_buffer, SERIAL4_TX_BUFFER_SIZE);
 #endif
\ No newline at end of file
@@ -6,5 +6,17 @@
 // otherwise we pay the RAM for *all* serial objects.
 
 #if defined(HAVE_HWSERIAL5)
-HardwareSerial Serial5(RX4, TX4, 4);
+#if !defined(SERIAL5_RX_BUFFER_SIZE)
+#define SERIAL5_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL5_TX_BUFFER_SIZE)
+#define SERIAL5_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+
+static unsigned char serial5_rx_buffer[SERIAL5_RX_BUFFER_SIZE];
+static unsigned char serial5_tx_buffer[SERIAL5_TX_BUFFER_SIZE];
+
+HardwareSerial Serial5(RX4, TX4, 4,
+                       serial5_rx_buffer, SERIAL5_RX_BUFFER_SIZE,
+                       serial5_tx_buffer, SERIAL5_TX_BUFFER_SIZE);
 #endif
\ No newline at end of file
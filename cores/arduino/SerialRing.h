@@ -0,0 +1,142 @@
+/*
+  SerialRing.h - Single producer / single consumer ring for HardwareSerial
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SerialRing_h
+#define SerialRing_h
+
+#include <stdint.h>
+#include "gd32xxyy.h"
+
+// A view on a ring buffer whose storage and indices live elsewhere (in
+// serial_t, so the C driver and the DMA code can reach them too).
+//
+// head and tail are free running: they are never wrapped, only masked when
+// the storage is accessed, so head - tail is always the fill level and no
+// division is needed. The size must be a power of two (see fit()) so that
+// the mask still lines up when the indices overflow. One slot always stays
+// free, the UART driver writes the incoming byte to the head slot before the
+// producer publishes it.
+//
+// Only the producer writes head and only the consumer writes tail. Each side
+// puts a barrier between touching the storage and publishing its index, so
+// the other side (an ISR or a DMA channel) never sees an index ahead of the
+// data.
+template <typename index_t>
+class SerialRing
+{
+    public:
+        SerialRing(uint8_t *buffer, index_t size, volatile index_t &head, volatile index_t &tail)
+            : _buffer(buffer), _mask(size - 1), _head(head), _tail(tail)
+        {
+        }
+
+        // Largest usable ring size not above size
+        static index_t fit(index_t size)
+        {
+            index_t fitted = 1;
+            while ((index_t)(fitted << 1) != 0 && (index_t)(fitted << 1) <= size) {
+                fitted <<= 1;
+            }
+            return fitted;
+        }
+
+        index_t capacity(void) const
+        {
+            return _mask;
+        }
+        index_t available(void) const
+        {
+            return (index_t)(_head - _tail);
+        }
+        index_t availableForWrite(void) const
+        {
+            return (index_t)(_mask - available());
+        }
+
+        // Producer side
+        bool push(uint8_t c)
+        {
+            index_t head = _head;
+            if ((index_t)(head - _tail) >= _mask) {
+                return false;
+            }
+            _buffer[head & _mask] = c;
+            __DMB();
+            _head = (index_t)(head + 1);
+            return true;
+        }
+        // Free room after head that can be written in one go
+        index_t writeSpan(uint8_t **span) const
+        {
+            index_t head = _head;
+            index_t room = (index_t)(_mask - (index_t)(head - _tail));
+            index_t to_end = (index_t)(_mask + 1 - (head & _mask));
+            *span = &_buffer[head & _mask];
+            return room < to_end ? room : to_end;
+        }
+        // Publish n bytes written through writeSpan()
+        void commit(index_t n)
+        {
+            __DMB();
+            _head = (index_t)(_head + n);
+        }
+
+        // Consumer side
+        int peek(void) const
+        {
+            index_t tail = _tail;
+            if (_head == tail) {
+                return -1;
+            }
+            return _buffer[tail & _mask];
+        }
+        int pop(void)
+        {
+            index_t tail = _tail;
+            if (_head == tail) {
+                return -1;
+            }
+            uint8_t c = _buffer[tail & _mask];
+            __DMB();
+            _tail = (index_t)(tail + 1);
+            return c;
+        }
+        // Pending bytes after tail that can be read in one go
+        index_t readSpan(const uint8_t **span) const
+        {
+            index_t tail = _tail;
+            index_t count = (index_t)(_head - tail);
+            index_t to_end = (index_t)(_mask + 1 - (tail & _mask));
+            *span = &_buffer[tail & _mask];
+            return count < to_end ? count : to_end;
+        }
+        // Hand n bytes read through readSpan() back to the producer
+        void consume(index_t n)
+        {
+            __DMB();
+            _tail = (index_t)(_tail + n);
+        }
+
+    private:
+        uint8_t *_buffer;
+        index_t _mask;
+        volatile index_t &_head;
+        volatile index_t &_tail;
+};
+
+#endif
@@ -0,0 +1,404 @@
+/*
+    Copyright (c) 2020, GigaDevice Semiconductor Inc.
+
+    Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its contributors
+       may be used to endorse or promote products derived from this software without
+       specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+OF SUCH DAMAGE.
+*/
+
+#include <stddef.h>
+#include "dma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if DMA_HAS_PERIPH_ARG
+#define DMA_CHAN_ARGS(ch)   (ch)->periph, (ch)->channel
+#define DMA_CHAN_INTF(ch)   DMA_INTF((ch)->periph)
+#define DMA_CHAN_INTC(ch)   DMA_INTC((ch)->periph)
+#define DMA_CHAN_CTL(ch)    DMA_CHCTL((ch)->periph, (ch)->channel)
+#define DMA_CHAN_CNT(ch)    DMA_CHCNT((ch)->periph, (ch)->channel)
+#else
+#define DMA_CHAN_ARGS(ch)   (ch)->channel
+#define DMA_CHAN_INTF(ch)   DMA_INTF
+#define DMA_CHAN_INTC(ch)   DMA_INTC
+#define DMA_CHAN_CTL(ch)    DMA_CHCTL((ch)->channel)
+#define DMA_CHAN_CNT(ch)    DMA_CHCNT((ch)->channel)
+#endif
+
+/* one nibble per channel in INTF/INTC */
+#define DMA_CHAN_FLAGS_MASK (DMA_INTF_GIF | DMA_INTF_FTFIF | DMA_INTF_HTFIF | DMA_INTF_ERRIF)
+#define DMA_CHAN_SHIFT(ch)  ((uint32_t)(ch)->channel * 4U)
+
+typedef struct {
+    dma_chan_t chan;
+    IRQn_Type irq;
+    dma_chan_callback_t callback;
+    void *param;
+} dma_chan_infor_t;
+
+static dma_chan_infor_t dma_chan_infor[DMA_CHANNEL_NUM] = {
+#if DMA_HAS_PERIPH_ARG
+    {{DMA0, DMA_CH0}, DMA0_Channel0_IRQn, NULL, NULL},
+    {{DMA0, DMA_CH1}, DMA0_Channel1_IRQn, NULL, NULL},
+    {{DMA0, DMA_CH2}, DMA0_Channel2_IRQn, NULL, NULL},
+    {{DMA0, DMA_CH3}, DMA0_Channel3_IRQn, NULL, NULL},
+    {{DMA0, DMA_CH4}, DMA0_Channel4_IRQn, NULL, NULL},
+    {{DMA0, DMA_CH5}, DMA0_Channel5_IRQn, NULL, NULL},
+    {{DMA0, DMA_CH6}, DMA0_Channel6_IRQn, NULL, NULL},
+#if defined(DMA_HAS_DMA1)
+    {{DMA1, DMA_CH0}, DMA1_Channel0_IRQn, NULL, NULL},
+    {{DMA1, DMA_CH1}, DMA1_Channel1_IRQn, NULL, NULL},
+    {{DMA1, DMA_CH2}, DMA1_Channel2_IRQn, NULL, NULL},
+#if defined(GD32F10X_CL) || defined(GD32F30X_CL) || defined(GD32E50X_CL) || defined(GD32E508)
+    {{DMA1, DMA_CH3}, DMA1_Channel3_IRQn, NULL, NULL},
+    {{DMA1, DMA_CH4}, DMA1_Channel4_IRQn, NULL, NULL},
+#else
+    {{DMA1, DMA_CH3}, DMA1_Channel3_Channel4_IRQn, NULL, NULL},
+    {{DMA1, DMA_CH4}, DMA1_Channel3_Channel4_IRQn, NULL, NULL},
+#endif
+#endif
+#else
+    {{DMA, DMA_CH0}, DMA_Channel0_IRQn, NULL, NULL},
+    {{DMA, DMA_CH1}, DMA_Channel1_2_IRQn, NULL, NULL},
+    {{DMA, DMA_CH2}, DMA_Channel1_2_IRQn, NULL, NULL},
+    {{DMA, DMA_CH3}, DMA_Channel3_4_IRQn, NULL, NULL},
+    {{DMA, DMA_CH4}, DMA_Channel3_4_IRQn, NULL, NULL},
+#endif
+};
+
+/** Find the bookkeeping slot of a channel
+ *
+ * @param ch The DMA channel
+ * @return The slot, or NULL if the channel is not handled here
+ */
+static dma_chan_infor_t *dma_chan_slot(const dma_chan_t *ch)
+{
+    uint32_t index = (uint32_t)ch->channel;
+
+    if (ch->periph == 0U) {
+        return NULL;
+    }
+#if defined(DMA_HAS_DMA1)
+    if (ch->periph == DMA1) {
+        index += 7U;
+    }
+#endif
+    if (index >= DMA_CHANNEL_NUM) {
+        return NULL;
+    }
+    return &dma_chan_infor[index];
+}
+
+/** Enable the clock of the DMA controller owning the channel
+ *
+ * @param ch The DMA channel
+ */
+static void dma_chan_clock_enable(const dma_chan_t *ch)
+{
+#if DMA_HAS_PERIPH_ARG
+#if defined(DMA_HAS_DMA1)
+    if (ch->periph == DMA1) {
+        rcu_periph_clock_enable(RCU_DMA1);
+        return;
+    }
+#endif
+    rcu_periph_clock_enable(RCU_DMA0);
+#else
+    (void)ch;
+    rcu_periph_clock_enable(RCU_DMA);
+#endif
+}
+
+/** Claim a DMA channel and route its interrupt to a callback
+ *
+ * @param ch       The DMA channel
+ * @param callback Called from the DMA interrupt with the channel flags
+ * @param param    Passed back to the callback
+ * @return 1 on success, 0 if the channel does not exist or is already owned
+ */
+uint8_t dma_chan_attach(const dma_chan_t *ch, dma_chan_callback_t callback, void *param)
+{
+    dma_chan_infor_t *slot = dma_chan_slot(ch);
+
+    if ((slot == NULL) || (callback == NULL) || (slot->callback != NULL)) {
+        return 0;
+    }
+
+    dma_chan_clock_enable(ch);
+    dma_deinit(DMA_CHAN_ARGS(ch));
+
+    slot->param = param;
+    slot->callback = callback;
+
+    NVIC_SetPriority(slot->irq, DMA_IRQ_PRIO);
+    NVIC_EnableIRQ(slot->irq);
+
+    return 1;
+}
+
+/** Stop a DMA channel and release it
+ *
+ * @param ch The DMA channel
+ */
+void dma_chan_detach(const dma_chan_t *ch)
+{
+    dma_chan_infor_t *slot = dma_chan_slot(ch);
+    uint32_t i;
+
+    if (slot == NULL) {
+        return;
+    }
+
+    dma_chan_stop(ch);
+    slot->callback = NULL;
+    slot->param = NULL;
+
+    /* the IRQ line may be shared with a neighbouring channel */
+    for (i = 0; i < DMA_CHANNEL_NUM; i++) {
+        if ((dma_chan_infor[i].irq == slot->irq) && (dma_chan_infor[i].callback != NULL)) {
+            return;
+        }
+    }
+    NVIC_DisableIRQ(slot->irq);
+}
+
+/** Configure a channel to move data between memory and a peripheral register
+ *
+ * @param ch          The DMA channel
+ * @param periph_addr Address of the peripheral data register
+ * @param direction   DMA_PERIPHERAL_TO_MEMORY or DMA_MEMORY_TO_PERIPHERAL
+ * @param width       Item size in bits: 8, 16 or 32
+ * @param circular    Non-zero to reload the transfer when it completes
+ * @param priority    One of DMA_PRIORITY_*
+ */
+void dma_chan_setup(const dma_chan_t *ch, uint32_t periph_addr, uint32_t direction,
+                    uint32_t width, uint8_t circular, uint32_t priority)
+{
+    dma_parameter_struct init;
+
+    dma_chan_stop(ch);
+    dma_deinit(DMA_CHAN_ARGS(ch));
+
+    init.periph_addr = periph_addr;
+    init.memory_addr = 0U;
+    init.number = 0U;
+    init.direction = direction;
+    init.priority = priority;
+    init.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    init.memory_inc = DMA_MEMORY_INCREASE_ENABLE;
+    if (width == 32U) {
+        init.periph_width = DMA_PERIPHERAL_WIDTH_32BIT;
+        init.memory_width = DMA_MEMORY_WIDTH_32BIT;
+    } else if (width == 16U) {
+        init.periph_width = DMA_PERIPHERAL_WIDTH_16BIT;
+        init.memory_width = DMA_MEMORY_WIDTH_16BIT;
+    } else {
+        init.periph_width = DMA_PERIPHERAL_WIDTH_8BIT;
+        init.memory_width = DMA_MEMORY_WIDTH_8BIT;
+    }
+    dma_init(DMA_CHAN_ARGS(ch), &init);
+
+    if (circular) {
+        dma_circulation_enable(DMA_CHAN_ARGS(ch));
+    } else {
+        dma_circulation_disable(DMA_CHAN_ARGS(ch));
+    }
+    dma_memory_to_memory_disable(DMA_CHAN_ARGS(ch));
+}
+
+/** Choose whether the memory address advances after each item
+ *
+ * A fixed address lets a single byte feed or swallow a whole transfer.
+ * @param ch     The DMA channel
+ * @param enable Non-zero to advance the memory address, zero to keep it
+ */
+void dma_chan_memory_increase(const dma_chan_t *ch, uint8_t enable)
+{
+    if (enable) {
+        dma_memory_increase_enable(DMA_CHAN_ARGS(ch));
+    } else {
+        dma_memory_increase_disable(DMA_CHAN_ARGS(ch));
+    }
+}
+
+/** Start a transfer on a channel prepared by dma_chan_setup
+ *
+ * @param ch          The DMA channel
+ * @param memory      The memory buffer
+ * @param count       Number of items to move
+ * @param int_sources DMA_INT_FTF / DMA_INT_HTF / DMA_INT_ERR to enable
+ */
+void dma_chan_start(const dma_chan_t *ch, const void *memory, uint32_t count, uint32_t int_sources)
+{
+    DMA_CHAN_CTL(ch) &= ~(DMA_CHXCTL_CHEN | DMA_INT_FTF | DMA_INT_HTF | DMA_INT_ERR);
+    DMA_CHAN_INTC(ch) = DMA_CHAN_FLAGS_MASK << DMA_CHAN_SHIFT(ch);
+
+    dma_memory_address_config(DMA_CHAN_ARGS(ch), (uint32_t)memory);
+    dma_transfer_number_config(DMA_CHAN_ARGS(ch), count);
+
+    DMA_CHAN_CTL(ch) |= int_sources | DMA_CHXCTL_CHEN;
+}
+
+/** Stop a channel and clear its pending flags
+ *
+ * @param ch The DMA channel
+ */
+void dma_chan_stop(const dma_chan_t *ch)
+{
+    DMA_CHAN_CTL(ch) &= ~(DMA_CHXCTL_CHEN | DMA_INT_FTF | DMA_INT_HTF | DMA_INT_ERR);
+    DMA_CHAN_INTC(ch) = DMA_CHAN_FLAGS_MASK << DMA_CHAN_SHIFT(ch);
+}
+
+/** Get the number of items left in the current transfer
+ *
+ * @param ch The DMA channel
+ * @return Value of the channel counter register
+ */
+uint32_t dma_chan_remaining(const dma_chan_t *ch)
+{
+    return DMA_CHAN_CNT(ch);
+}
+
+/** Check whether a channel is still transferring
+ *
+ * @param ch The DMA channel
+ * @return 1 if the channel is enabled and has items left, 0 otherwise
+ */
+uint8_t dma_chan_busy(const dma_chan_t *ch)
+{
+    return ((DMA_CHAN_CTL(ch) & DMA_CHXCTL_CHEN) && (DMA_CHAN_CNT(ch) != 0U)) ? 1 : 0;
+}
+
+/** Common DMA channel interrupt handler
+ *
+ * @param index Slot of the channel in dma_chan_infor
+ */
+static void dma_chan_irq(uint32_t index)
+{
+    dma_chan_infor_t *slot = &dma_chan_infor[index];
+    uint32_t shift = DMA_CHAN_SHIFT(&slot->chan);
+    uint32_t flags = (DMA_CHAN_INTF(&slot->chan) >> shift) & DMA_CHAN_FLAGS_MASK;
+
+    if (flags == 0U) {
+        return;
+    }
+    DMA_CHAN_INTC(&slot->chan) = flags << shift;
+
+    if (slot->callback != NULL) {
+        slot->callback(slot->param, flags & ~DMA_INTF_GIF);
+    }
+}
+
+#if DMA_HAS_PERIPH_ARG
+void DMA0_Channel0_IRQHandler(void)
+{
+    dma_chan_irq(0);
+}
+
+void DMA0_Channel1_IRQHandler(void)
+{
+    dma_chan_irq(1);
+}
+
+void DMA0_Channel2_IRQHandler(void)
+{
+    dma_chan_irq(2);
+}
+
+void DMA0_Channel3_IRQHandler(void)
+{
+    dma_chan_irq(3);
+}
+
+void DMA0_Channel4_IRQHandler(void)
+{
+    dma_chan_irq(4);
+}
+
+void DMA0_Channel5_IRQHandler(void)
+{
+    dma_chan_irq(5);
+}
+
+void DMA0_Channel6_IRQHandler(void)
+{
+    dma_chan_irq(6);
+}
+
+#if defined(DMA_HAS_DMA1)
+void DMA1_Channel0_IRQHandler(void)
+{
+    dma_chan_irq(7);
+}
+
+void DMA1_Channel1_IRQHandler(void)
+{
+    dma_chan_irq(8);
+}
+
+void DMA1_Channel2_IRQHandler(void)
+{
+    dma_chan_irq(9);
+}
+
+#if defined(GD32F10X_CL) || defined(GD32F30X_CL) || defined(GD32E50X_CL) || defined(GD32E508)
+void DMA1_Channel3_IRQHandler(void)
+{
+    dma_chan_irq(10);
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+    dma_chan_irq(11);
+}
+#else
+void DMA1_Channel3_4_IRQHandler(void)
+{
+    dma_chan_irq(10);
+    dma_chan_irq(11);
+}
+#endif
+#endif /* DMA_HAS_DMA1 */
+#else
+void DMA_Channel0_IRQHandler(void)
+{
+    dma_chan_irq(0);
+}
+
+void DMA_Channel1_2_IRQHandler(void)
+{
+    dma_chan_irq(1);
+    dma_chan_irq(2);
+}
+
+void DMA_Channel3_4_IRQHandler(void)
+{
+    dma_chan_irq(3);
+    dma_chan_irq(4);
+}
+#endif /* DMA_HAS_PERIPH_ARG */
+
+#ifdef __cplusplus
+}
+#endif
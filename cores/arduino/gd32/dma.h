@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2020, GigaDevice Semiconductor Inc.
+
+    Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its contributors
+       may be used to endorse or promote products derived from this software without
+       specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+OF SUCH DAMAGE.
+*/
+
+#ifndef DMA_H
+#define DMA_H
+
+#include "gd32xxyy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The F10x/F30x/E50x firmware addresses a channel as (DMAx, DMA_CHx), the
+ * single-controller series (F1x0/F3x0/E23x) only by DMA_CHx. */
+#if defined(GD32F10x) || defined(GD32F30x) || defined(GD32E50X)
+#define DMA_HAS_PERIPH_ARG 1
+#if defined(GD32F10X_HD) || defined(GD32F10X_XD) || defined(GD32F10X_CL) || \
+    defined(GD32F30X_HD) || defined(GD32F30X_XD) || defined(GD32F30X_CL) || \
+    defined(GD32E50X_HD) || defined(GD32E50X_XD) || defined(GD32E50X_CL) || \
+    defined(GD32EPRT) || defined(GD32E508)
+#define DMA_HAS_DMA1 1
+#endif
+#else
+#define DMA_HAS_PERIPH_ARG 0
+#endif
+
+/* DMA_CH0 .. DMA_CH6 of DMA0, then DMA_CH0 .. DMA_CH4 of DMA1 */
+#if defined(DMA_HAS_DMA1)
+#define DMA_CHANNEL_NUM 12
+#elif DMA_HAS_PERIPH_ARG
+#define DMA_CHANNEL_NUM 7
+#else
+#define DMA_CHANNEL_NUM 5
+#endif
+
+#define DMA_IRQ_PRIO 1
+
+/* flags passed to the channel callback, same bit layout as DMA_INTF per channel */
+#define DMA_CHAN_FLAG_FTF DMA_INTF_FTFIF
+#define DMA_CHAN_FLAG_HTF DMA_INTF_HTFIF
+#define DMA_CHAN_FLAG_ERR DMA_INTF_ERRIF
+
+/* A DMA channel tied to a peripheral request line. periph is 0 when the
+ * peripheral has no DMA request on this part. */
+typedef struct {
+    uint32_t periph;
+    dma_channel_enum channel;
+} dma_chan_t;
+
+typedef void (*dma_chan_callback_t)(void *param, uint32_t flags);
+
+/* Claim a channel and route its interrupt to callback. Returns 0 if the channel is already owned. */
+uint8_t dma_chan_attach(const dma_chan_t *ch, dma_chan_callback_t callback, void *param);
+/* Stop the channel and release it */
+void dma_chan_detach(const dma_chan_t *ch);
+/* Configure the channel for a peripheral data register, without starting it */
+void dma_chan_setup(const dma_chan_t *ch, uint32_t periph_addr, uint32_t direction,
+                    uint32_t width, uint8_t circular, uint32_t priority);
+/* Step through memory after each item (the default after setup), or keep hitting the same location */
+void dma_chan_memory_increase(const dma_chan_t *ch, uint8_t enable);
+/* Start a transfer of count items from/to memory, enabling the given DMA_INT_* sources */
+void dma_chan_start(const dma_chan_t *ch, const void *memory, uint32_t count, uint32_t int_sources);
+/* Stop the channel and clear its pending flags */
+void dma_chan_stop(const dma_chan_t *ch);
+/* Items left in the current transfer (the CHxCNT register) */
+uint32_t dma_chan_remaining(const dma_chan_t *ch);
+/* Check whether the channel is enabled and still running */
+uint8_t dma_chan_busy(const dma_chan_t *ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMA_H */
@@ -97,4 +97,18 @@ uint32_t getCurrentMicros(void)
     uint32_t systick_load = SysTick->LOAD + 1;
     uint32_t us = ((systick_load - systick_value) * 1000) / systick_load;
     return (ms * 1000 + us);
-}
\ No newline at end of file
+}
+/*!
+    \brief      account for ticks missed while interrupts were disabled
+    \param[in]  ms: milliseconds whose SysTick interrupt did not run
+    \param[out] none
+    \retval     none
+*/
+void addCurrentMillis(uint32_t ms)
+{
+    /* the read-modify-write must not race a SysTick increment */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    gd_ticks += ms;
+    __set_PRIMASK(primask);
+}
@@ -46,5 +46,6 @@ OF SUCH DAMAGE.
 void systick_config(void);
 uint32_t getCurrentMillis(void);
 uint32_t getCurrentMicros(void);
+void addCurrentMillis(uint32_t ms);
 
 #endif /* SYSTICK_H */
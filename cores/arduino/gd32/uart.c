@@ -28,6 +28,7 @@ OF SUCH DAMAGE.
 */
 
 #include "uart.h"
+#include "dma.h"
 #include "Arduino.h"
 
 #if defined(USART_DATA)
@@ -46,11 +47,26 @@ OF SUCH DAMAGE.
 #error "We don't understand this USART peripheral."
 #endif
 
+/* One priority for the USART interrupt, for both directions, and for the
+   DMA channels that serve it: usart_rx_dma_update() runs from the IDLE/RT
+   interrupt and from the RX channel's half/full transfer interrupt, and
+   must never preempt itself */
+#define USART_IRQ_PRIO DMA_IRQ_PRIO
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 struct serial_s *obj_s_buf[UART_NUM] = {NULL};
+
+/* USARTs with a receiver timeout, they come first in the index order */
+#if defined(GD32F30x) || defined(GD32E50X)
+#define USART_RT_NUM 3
+#elif defined(GD32F3x0) || defined(GD32F1x0) || defined(GD32E23x)
+#define USART_RT_NUM 1
+#else
+#define USART_RT_NUM 0
+#endif
 static rcu_periph_enum usart_clk[UART_NUM]  = {
     RCU_USART0,
     RCU_USART1,
@@ -78,6 +94,40 @@ static IRQn_Type usart_irq_n[UART_NUM]      = {
 #endif
 };
 
+/* DMA request lines of the USART receivers, periph 0 where there is none */
+static const dma_chan_t usart_rx_dma[UART_NUM] = {
+#if DMA_HAS_PERIPH_ARG
+    [UART0_INDEX] = {DMA0, DMA_CH4},
+    [UART1_INDEX] = {DMA0, DMA_CH5},
+#ifdef USART2
+    [UART2_INDEX] = {DMA0, DMA_CH2},
+#endif
+#if defined(DMA_HAS_DMA1) && (defined(UART3) || defined(USART3))
+    [UART3_INDEX] = {DMA1, DMA_CH2},
+#endif
+#else
+    [UART0_INDEX] = {DMA, DMA_CH2},
+    [UART1_INDEX] = {DMA, DMA_CH4},
+#endif
+};
+
+/* DMA request lines of the USART transmitters */
+static const dma_chan_t usart_tx_dma[UART_NUM] = {
+#if DMA_HAS_PERIPH_ARG
+    [UART0_INDEX] = {DMA0, DMA_CH3},
+    [UART1_INDEX] = {DMA0, DMA_CH6},
+#ifdef USART2
+    [UART2_INDEX] = {DMA0, DMA_CH1},
+#endif
+#if defined(DMA_HAS_DMA1) && (defined(UART3) || defined(USART3))
+    [UART3_INDEX] = {DMA1, DMA_CH4},
+#endif
+#else
+    [UART0_INDEX] = {DMA, DMA_CH1},
+    [UART1_INDEX] = {DMA, DMA_CH3},
+#endif
+};
+
 #define GET_SERIAL_S(obj) (obj)
 
 /** Initialize the USART peripheral.
@@ -162,6 +212,10 @@ void serial_init(serial_t *obj, PinName tx, PinName rx)
 #endif
     }
 
+    /* a previous begin() may have left the DMA channels claimed */
+    serial_rx_dma_stop(obj);
+    serial_tx_dma_stop(obj);
+
     /* configurte the pins */
     pinmap_pinout(tx, PinMap_UART_TX);
     pinmap_pinout(rx, PinMap_UART_RX);
@@ -195,6 +249,9 @@ void serial_free(serial_t *obj)
     struct serial_s *p_obj     = GET_SERIAL_S(obj);
     rcu_periph_enum rcu_periph = usart_clk[p_obj->index];
 
+    serial_rx_dma_stop(obj);
+    serial_tx_dma_stop(obj);
+
     /* reset USART and disable clock */
     usart_deinit(p_obj->uart);
     rcu_periph_clock_disable(rcu_periph);
@@ -235,6 +292,176 @@ void serial_baud(serial_t *obj, int baudrate)
     }
 }
 
+/* USARTs with auto baud rate detection, USART0 only */
+#if defined(GD32F3x0) || defined(GD32F1x0) || defined(GD32E23x)
+#define USART_ABD_NUM 1
+#else
+#define USART_ABD_NUM 0
+#endif
+
+/* Rates a measurement is rounded to when it is within 1/16 of one */
+static const uint32_t usart_std_baud[] = {
+    1200U, 2400U, 4800U, 9600U, 14400U, 19200U, 28800U, 38400U, 57600U,
+    76800U, 115200U, 230400U, 250000U, 460800U, 500000U, 921600U, 1000000U
+};
+
+static uint32_t usart_baud_round(uint32_t baud)
+{
+    uint32_t i, diff;
+
+    for (i = 0U; i < sizeof(usart_std_baud) / sizeof(usart_std_baud[0]); i++) {
+        diff = (baud > usart_std_baud[i]) ? baud - usart_std_baud[i] : usart_std_baud[i] - baud;
+        if (diff <= usart_std_baud[i] / 16U) {
+            return usart_std_baud[i];
+        }
+    }
+    return baud;
+}
+
+#if USART_ABD_NUM > 0
+/** Let the USART measure the start bit of the next character
+ *
+ * @param p_obj   The serial object
+ * @param timeout Milliseconds to wait for the character
+ * @return The measured rate, 0 on timeout or detection error
+ */
+static uint32_t usart_abd_measure(struct serial_s *p_obj, uint32_t timeout)
+{
+    uint32_t start = getCurrentMillis();
+    uint32_t stat, div;
+    uint16_t uen_flag = USART_CTL0(p_obj->uart) & USART_CTL0_UEN;
+
+    usart_disable(p_obj->uart);
+    usart_autobaud_detection_mode_config(p_obj->uart, USART_ABDM_FTOR);
+    usart_autobaud_detection_enable(p_obj->uart);
+    usart_enable(p_obj->uart);
+    do {
+        stat = USART_STAT(p_obj->uart);
+    } while (!(stat & (USART_STAT_ABDF | USART_STAT_ABDE)) && (getCurrentMillis() - start < timeout));
+    usart_disable(p_obj->uart);
+    usart_autobaud_detection_disable(p_obj->uart);
+    if (RESET != uen_flag) {
+        usart_enable(p_obj->uart);
+    }
+
+    div = USART_BAUD(p_obj->uart);
+    if (!(stat & USART_STAT_ABDF) || (stat & USART_STAT_ABDE) || (div == 0U)) {
+        return 0U;
+    }
+    if (USART_CTL0(p_obj->uart) & USART_CTL0_OVSMOD) {
+        /* oversampling by 8 keeps the fraction one bit to the right */
+        return (2U * rcu_clock_freq_get(CK_USART)) / ((div & 0xFFF0U) | ((div & 0x7U) << 1));
+    }
+    return rcu_clock_freq_get(CK_USART) / div;
+}
+#endif
+
+/** Time the edges of the next character on the RX pin against SysTick. The
+ *  shortest pulse is one bit, so the character needs an isolated 0 or 1 bit
+ *  (any odd character such as 'U' or CR has one right after the start bit).
+ *  Interrupts are off from the start bit to the end of the character, and
+ *  never longer than 11 bit times at the lowest rate in usart_std_baud.
+ *
+ * @param p_obj   The serial object
+ * @param timeout Milliseconds to wait for the character
+ * @return The measured rate, 0 on timeout
+ */
+static uint32_t usart_edge_measure(struct serial_s *p_obj, uint32_t timeout)
+{
+    uint32_t port = gpio_port[GD_PORT_GET(p_obj->pin_rx)];
+    uint32_t pin = gpio_pin[GD_PIN_GET(p_obj->pin_rx)];
+    uint32_t start = getCurrentMillis();
+    uint32_t reload = SysTick->LOAD + 1U;
+    uint32_t limit = (SystemCoreClock / usart_std_baud[0]) * 11U;
+    uint32_t shortest = 0xFFFFFFFFU, pulse, last_edge = 0U, edges = 0U, wraps = 0U;
+    uint32_t prev, val, elapsed = 0U, level, primask;
+
+    /* wait for an idle line, then for the falling edge of a start bit */
+    while (!(GPIO_ISTAT(port) & pin)) {
+        if (getCurrentMillis() - start >= timeout) {
+            return 0U;
+        }
+    }
+    while (GPIO_ISTAT(port) & pin) {
+        if (getCurrentMillis() - start >= timeout) {
+            return 0U;
+        }
+    }
+
+    /* the start bit may have been stretched by an interrupt, time from the
+       first edge after it with interrupts off. A pulse is at least one bit,
+       so once one has been measured the character is over 11 of the shortest
+       pulses after the start bit, or once the line has been high for 10 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    level = 0U;
+    prev = SysTick->VAL;
+    while (elapsed < limit) {
+        val = SysTick->VAL;
+        if (val > prev) {
+            elapsed += prev + reload - val;
+            wraps++;
+        } else {
+            elapsed += prev - val;
+        }
+        prev = val;
+        if ((GPIO_ISTAT(port) & pin) ? !level : level) {
+            level = !level;
+            if (edges++ > 0U) {
+                pulse = elapsed - last_edge;
+                if (pulse < shortest) {
+                    shortest = pulse;
+                    if (11U * shortest < limit) {
+                        limit = 11U * shortest;
+                    }
+                }
+            }
+            last_edge = elapsed;
+        } else if (level && (shortest != 0xFFFFFFFFU) && (elapsed - last_edge > 10U * shortest)) {
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+    /* the pending SysTick interrupt accounts for one of the missed ticks */
+    if (wraps > 1U) {
+        addCurrentMillis(wraps - 1U);
+    }
+
+    if ((shortest == 0xFFFFFFFFU) || (shortest == 0U)) {
+        return 0U;
+    }
+    return SystemCoreClock / shortest;
+}
+
+/** Measure the rate of the next character on the RX line and switch to it.
+ *  USART0 of the GD32F3x0/F1x0/E23x uses its auto baud rate detection, the
+ *  other USARTs time the RX pin edges. The character itself is not received.
+ *
+ * @param obj     The serial object, set up by serial_init()
+ * @param timeout Milliseconds to wait for the character
+ * @return The new baud rate, 0 if none was detected
+ */
+uint32_t serial_autobaud(serial_t *obj, uint32_t timeout)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    uint32_t baud;
+
+#if USART_ABD_NUM > 0
+    if (p_obj->index < USART_ABD_NUM) {
+        baud = usart_abd_measure(p_obj, timeout);
+    } else
+#endif
+    {
+        baud = usart_edge_measure(p_obj, timeout);
+    }
+    if (baud == 0U) {
+        return 0U;
+    }
+    baud = usart_baud_round(baud);
+    serial_baud(obj, baud);
+    return baud;
+}
+
 /** Configure the format. Set the number of bits, parity and the number of stop bits
  *
  * @param obj       The serial object
@@ -506,6 +733,22 @@ static gd_status_enum usart_tx_interrupt(struct serial_s *obj_s)
     }
 }
 
+/** Switch the RS-485 transceiver between driving and listening
+ *
+ * @param obj_s  The serial object
+ * @param enable 1 to drive the bus, 0 to release it
+ */
+static void usart_de_write(struct serial_s *obj_s, uint8_t enable)
+{
+    PinName de = obj_s->de_pin;
+
+    if (de == NC) {
+        return;
+    }
+    gpio_bit_write(gpio_port[GD_PORT_GET(de)], gpio_pin[GD_PIN_GET(de)],
+                   (bit_status)(enable ? obj_s->de_level : !obj_s->de_level));
+}
+
 /** Handle the serial tx complete interrupt
  *
  * @param obj_s The serial object
@@ -516,6 +759,10 @@ static void usart_tx_complete_interrupt(struct serial_s *obj_s)
 
     obj_s->tx_state = OP_STATE_READY;
     obj_s->tx_callback(obj_s);
+    /* release the bus unless the callback has queued more data */
+    if (obj_s->tx_state == OP_STATE_READY) {
+        usart_de_write(obj_s, 0U);
+    }
 }
 
 /**
@@ -607,10 +854,11 @@ int serial_transmit(serial_t *obj, const void *tx, size_t tx_length)
     /* disable the IRQ first */
     NVIC_DisableIRQ(irq);
     /* set the priority and vector */
-    NVIC_SetPriority(irq, 1);
+    NVIC_SetPriority(irq, USART_IRQ_PRIO);
     /* enable IRQ */
     NVIC_EnableIRQ(irq);
 
+    usart_de_write(p_obj, 1U);
     if (usart_tx_interrupt_preprocess(p_obj, (uint8_t *)tx, tx_length) != GD_OK) {
         return 0;
     }
@@ -646,14 +894,623 @@ void serial_receive(serial_t *obj, void *rx, size_t rx_length)
     NVIC_ClearPendingIRQ(irq);
     /* disable the IRQ first */
     NVIC_DisableIRQ(irq);
-    /* set the priority(higher than Tx) and vector */
-    NVIC_SetPriority(irq, 0);
+    /* set the priority and vector */
+    NVIC_SetPriority(irq, USART_IRQ_PRIO);
     /* enable IRQ */
     NVIC_EnableIRQ(irq);
 
     usart_rx_interrupt_preprocess(p_obj, (uint8_t *)rx, rx_length);
 }
 
+/** Look for char_match in the bytes the DMA channel has written since the last call,
+ *  the callback runs once for each match
+ *
+ * @param obj_s The serial object
+ * @param head  The new RX head
+ */
+static void usart_rx_dma_match(struct serial_s *obj_s, uint16_t head)
+{
+    uint16_t mask = obj_s->rx_size - 1U;
+    uint16_t i = obj_s->rx_match;
+
+    /* no need to look at what has been read already */
+    if ((int16_t)(obj_s->rx_tail - i) > 0) {
+        i = obj_s->rx_tail;
+    }
+    obj_s->rx_match = head;
+    for (; i != head; i++) {
+        if (obj_s->rx_buff[i & mask] == obj_s->char_match) {
+            obj_s->match_callback();
+        }
+    }
+}
+
+/** Publish the DMA write position as the new RX head and notify the owner
+ *
+ * @param obj_s The serial object
+ */
+static void usart_rx_dma_update(struct serial_s *obj_s)
+{
+    uint16_t head, level;
+
+    if (!obj_s->rx_dma) {
+        return;
+    }
+    head  = serial_rx_dma_head(obj_s);
+    level = head - obj_s->rx_tail;
+    obj_s->stats.rx_bytes += (uint16_t)(head - obj_s->rx_head);
+    if (level > obj_s->stats.rx_peak) {
+        obj_s->stats.rx_peak = level;
+    }
+    obj_s->rx_head = head;
+    if (obj_s->rts_pin != NC) {
+        serial_rts_update(obj_s);
+    }
+    if (obj_s->match_callback != NULL) {
+        usart_rx_dma_match(obj_s, head);
+    }
+    if (obj_s->rx_callback != NULL) {
+        obj_s->rx_callback(obj_s);
+    }
+}
+
+/** DMA half/full transfer interrupt of the RX channel
+ *
+ * @param param The serial object
+ * @param flags The DMA channel flags
+ */
+static void usart_rx_dma_irq(void *param, uint32_t flags)
+{
+    (void)flags;
+    usart_rx_dma_update((struct serial_s *)param);
+}
+
+/** Clear the IDLE line flag
+ *
+ * @param obj_s The serial object
+ */
+static void usart_idle_flag_clear(struct serial_s *obj_s)
+{
+#if defined(GD32F10x) || defined(GD32F30x) || defined(GD32E50X)
+    /* IDLEF is cleared by reading STAT followed by DATA */
+    (void)GD32_USART_STAT(obj_s->uart);
+    (void)GD32_USART_RX_DATA(obj_s->uart);
+#else
+    usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_IDLE);
+#endif
+}
+
+/** Start circular DMA reception into rx_buff. The DMA channel writes the
+ *  ring on its own, the head is published on IDLE line and on half/full
+ *  transfer, so there is no interrupt per byte.
+ *
+ * @param obj  The serial object
+ * @param size Size of rx_buff, a power of two
+ * @return 1 if DMA reception was started, 0 if the caller must fall back to serial_receive()
+ */
+uint8_t serial_rx_dma_start(serial_t *obj, uint16_t size)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    const dma_chan_t *ch;
+    IRQn_Type irq;
+
+    if ((p_obj->index >= UART_NUM) || (p_obj->rx_buff == NULL) || (size == 0U) || ((size & (size - 1U)) != 0U)) {
+        return 0;
+    }
+
+    /* 7 data bits + parity need the parity bit masked off, which DMA cannot do */
+    if ((USART_CTL0(p_obj->uart) & (USART_CTL0_PCEN | USART_CTL0_WL)) == USART_CTL0_PCEN) {
+        return 0;
+    }
+
+    ch = &usart_rx_dma[p_obj->index];
+    if (!dma_chan_attach(ch, usart_rx_dma_irq, p_obj)) {
+        return 0;
+    }
+
+    p_obj->rx_size  = size;
+    p_obj->rx_head  = 0U;
+    p_obj->rx_dma   = 1U;
+    p_obj->rx_state = OP_STATE_BUSY_RX;
+
+    dma_chan_setup(ch, (uint32_t)&GD32_USART_RX_DATA(p_obj->uart), DMA_PERIPHERAL_TO_MEMORY, 8U, 1U,
+                   DMA_PRIORITY_HIGH);
+    dma_chan_start(ch, p_obj->rx_buff, size, DMA_INT_HTF | DMA_INT_FTF);
+    USART_CTL2(p_obj->uart) |= USART_CTL2_DENR;
+
+    irq = usart_irq_n[p_obj->index];
+    NVIC_ClearPendingIRQ(irq);
+    NVIC_SetPriority(irq, USART_IRQ_PRIO);
+    NVIC_EnableIRQ(irq);
+
+    usart_idle_flag_clear(p_obj);
+    usart_interrupt_enable(p_obj->uart, USART_INT_IDLE);
+    usart_interrupt_enable(p_obj->uart, USART_INT_ERR);
+    usart_interrupt_enable(p_obj->uart, USART_INT_PERR);
+
+    return 1;
+}
+
+/** Stop circular DMA reception
+ *
+ * @param obj The serial object
+ */
+void serial_rx_dma_stop(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    if (!p_obj->rx_dma) {
+        return;
+    }
+
+    usart_interrupt_disable(p_obj->uart, USART_INT_IDLE);
+    usart_interrupt_disable(p_obj->uart, USART_INT_ERR);
+    usart_interrupt_disable(p_obj->uart, USART_INT_PERR);
+    USART_CTL2(p_obj->uart) &= ~USART_CTL2_DENR;
+    dma_chan_detach(&usart_rx_dma[p_obj->index]);
+
+    p_obj->rx_dma   = 0U;
+    p_obj->rx_state = OP_STATE_READY;
+}
+
+/** Make a pin a push-pull GPIO output
+ *
+ * @param pin The pin
+ */
+static void usart_gpio_output(PinName pin)
+{
+#if defined(GD32F30x) || defined(GD32F10x) || defined(GD32E50X)
+    pin_function(pin, GD_PIN_FUNCTION3(PIN_MODE_OUT_PP, PIN_OTYPE_PP, 0));
+#else
+    pin_function(pin, GD_PIN_FUNCTION3(PIN_MODE_OUTPUT, PIN_OTYPE_PP, 0));
+#endif
+}
+
+/** Set up hardware flow control. CTS must be a CTS pin of the USART. RTS may
+ *  be any pin, it is driven by the USART when it is the USART's RTS pin and
+ *  as a GPIO otherwise. Either way it is also dropped while the RX ring is
+ *  above its high-water mark, see serial_rts_update().
+ *
+ * @param obj The serial object
+ * @param rts The RTS pin, NC for none
+ * @param cts The CTS pin, NC for none
+ * @return 1 on success, 0 if cts is not a CTS pin of this USART
+ */
+uint8_t serial_flow_control(serial_t *obj, PinName rts, PinName cts)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    if ((cts != NC) && (pinmap_peripheral(cts, PinMap_UART_CTS) != p_obj->uart)) {
+        p_obj->rts_pin = NC;
+        p_obj->cts_pin = NC;
+        return 0;
+    }
+
+    p_obj->rts_pin  = rts;
+    p_obj->cts_pin  = cts;
+    p_obj->rts_hw   = (rts != NC) && (pinmap_peripheral(rts, PinMap_UART_RTS) == p_obj->uart);
+    p_obj->rts_held = 0U;
+
+    if (p_obj->rts_hw) {
+        pinmap_pinout(rts, PinMap_UART_RTS);
+        usart_hardware_flow_rts_config(p_obj->uart, USART_RTS_ENABLE);
+    } else {
+        usart_hardware_flow_rts_config(p_obj->uart, USART_RTS_DISABLE);
+        if (rts != NC) {
+            /* RTS is active low */
+            gpio_bit_reset(gpio_port[GD_PORT_GET(rts)], gpio_pin[GD_PIN_GET(rts)]);
+            usart_gpio_output(rts);
+        }
+    }
+
+    if (cts == NC) {
+        usart_hardware_flow_cts_config(p_obj->uart, USART_CTS_DISABLE);
+    } else {
+        pinmap_pinout(cts, PinMap_UART_CTS);
+        usart_hardware_flow_cts_config(p_obj->uart, USART_CTS_ENABLE);
+    }
+
+    return 1;
+}
+
+/** Drop RTS while the RX ring is above three quarters full and raise it again
+ *  once it has drained to a quarter. The USART RTS output only covers the
+ *  single receive register, so an RTS pin is switched to a GPIO while held.
+ *  May be called from the RX interrupt and from the reader.
+ *
+ * @param obj The serial object
+ */
+void serial_rts_update(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    PinName rts = p_obj->rts_pin;
+    uint16_t size = p_obj->rx_buff_size;
+    uint16_t level;
+    uint32_t primask;
+
+    if (rts == NC) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    level = (uint16_t)(serial_rx_head(obj) - p_obj->rx_tail);
+    if (!p_obj->rts_held && (level >= size - size / 4U)) {
+        p_obj->rts_held = 1U;
+        gpio_bit_set(gpio_port[GD_PORT_GET(rts)], gpio_pin[GD_PIN_GET(rts)]);
+        if (p_obj->rts_hw) {
+            usart_gpio_output(rts);
+        }
+    } else if (p_obj->rts_held && (level <= size / 4U)) {
+        p_obj->rts_held = 0U;
+        if (p_obj->rts_hw) {
+            pinmap_pinout(rts, PinMap_UART_RTS);
+        } else {
+            gpio_bit_reset(gpio_port[GD_PORT_GET(rts)], gpio_pin[GD_PIN_GET(rts)]);
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/** Drive an RS-485 driver enable pin. The pin goes to level before the first
+ *  frame of a transmission and back in the transmit complete interrupt.
+ *
+ * @param obj   The serial object
+ * @param de    The driver enable pin, NC to stop driving it
+ * @param level The level that enables the driver
+ */
+void serial_rs485(serial_t *obj, PinName de, uint8_t level)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    /* leave a previous pin listening */
+    usart_de_write(p_obj, 0U);
+    p_obj->de_pin = NC;
+    if (de == NC) {
+        return;
+    }
+
+    usart_gpio_output(de);
+    p_obj->de_level = level ? 1U : 0U;
+    p_obj->de_pin = de;
+    usart_de_write(p_obj, 0U);
+}
+
+/** Call callback from the RX interrupt once a given character has been received.
+ *  With DMA reception the bytes are looked at on idle line and half/full transfer.
+ *
+ * @param obj      The serial object
+ * @param c        The character to match, SERIAL_RESERVED_CHAR_MATCH disables matching
+ * @param callback The function to call, NULL disables matching
+ */
+void serial_char_match(serial_t *obj, uint8_t c, void (*callback)(void))
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    p_obj->match_callback = NULL;
+    p_obj->char_match     = c;
+    p_obj->rx_match       = p_obj->rx_head;
+    if (c != SERIAL_RESERVED_CHAR_MATCH) {
+        p_obj->match_callback = callback;
+    }
+}
+
+/** Call callback from the USART interrupt when the RX line goes idle after a frame
+ *
+ * @param obj      The serial object
+ * @param callback The function to call, NULL disables the notification
+ */
+void serial_idle_notify(serial_t *obj, void (*callback)(void))
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    p_obj->idle_callback = callback;
+    /* DMA reception and idle line frames need the IDLE interrupt anyway */
+    if (p_obj->rx_dma || (p_obj->frame_mode == SERIAL_FRAME_IDLE)) {
+        return;
+    }
+    if (callback != NULL) {
+        usart_idle_flag_clear(p_obj);
+        usart_interrupt_enable(p_obj->uart, USART_INT_IDLE);
+    } else {
+        usart_interrupt_disable(p_obj->uart, USART_INT_IDLE);
+    }
+}
+
+/** Get the length of one character on the line
+ *
+ * @param obj The serial object
+ * @return Number of bit times, start, parity and stop bits included
+ */
+uint32_t serial_char_bits(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    uint32_t bits = (USART_CTL0(p_obj->uart) & USART_CTL0_WL) ? 10U : 9U;
+
+    return bits + (((USART_CTL1(p_obj->uart) & USART_CTL1_STB) == USART_STB_2BIT) ? 2U : 1U);
+}
+
+/** Join a multi-drop bus. Words are 9 bits wide and a set 9th bit marks an
+ *  address. The receiver stays mute, without raising RX interrupts, until an
+ *  address mark carrying addr arrives, and goes mute again by itself on the
+ *  next address mark for another node. The address has 4 bits on the
+ *  GD32F10x/F30x/E50x and 8 bits on the other series.
+ *
+ * @param obj  The serial object
+ * @param addr The address of this node
+ */
+void serial_multidrop(serial_t *obj, uint8_t addr)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    uint16_t uen_flag = USART_CTL0(p_obj->uart) & USART_CTL0_UEN;
+
+    usart_disable(p_obj->uart);
+    usart_parity_config(p_obj->uart, USART_PM_NONE);
+    p_obj->parity = USART_PM_NONE;
+    usart_word_length_set(p_obj->uart, USART_WL_9BIT);
+    usart_mute_mode_wakeup_config(p_obj->uart, USART_WM_ADDR);
+#if defined(USART_CTL0_MEN)
+    usart_address_detection_mode_config(p_obj->uart, USART_ADDM_FULLBIT);
+    usart_address_config(p_obj->uart, addr);
+    usart_mute_mode_enable(p_obj->uart);
+#else
+    usart_address_config(p_obj->uart, addr & 0x0FU);
+#endif
+    if (RESET != uen_flag) {
+        usart_enable(p_obj->uart);
+    }
+    serial_mute(obj);
+}
+
+/** Ignore the bus until the next address mark for this node
+ *
+ * @param obj The serial object, set up by serial_multidrop()
+ */
+void serial_mute(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+#if defined(USART_CTL0_MEN)
+    usart_command_enable(p_obj->uart, USART_CMD_MMCMD);
+#else
+    usart_mute_mode_enable(p_obj->uart);
+#endif
+}
+
+/** Send an address mark. Waits for the transmitter, and with RS-485 for the
+ *  mark to be on the wire so the bus can be released.
+ *
+ * @param obj  The serial object, set up by serial_multidrop()
+ * @param addr The address to select
+ */
+void serial_send_address(serial_t *obj, uint8_t addr)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    while (usart_flag_get(p_obj->uart, USART_FLAG_TBE) == RESET) {
+    }
+    usart_de_write(p_obj, 1U);
+    usart_flag_clear(p_obj->uart, USART_FLAG_TC);
+    GD32_USART_TX_DATA(p_obj->uart) = (uint16_t)(0x100U | addr);
+    if (p_obj->de_pin != NC) {
+        while (usart_flag_get(p_obj->uart, USART_FLAG_TC) == RESET) {
+        }
+        if (p_obj->tx_state == OP_STATE_READY) {
+            usart_de_write(p_obj, 0U);
+        }
+    }
+}
+
+/** Start queueing received frames. A frame ends after a given silence on the
+ *  line, which the USART receiver timeout measures where there is one.
+ *
+ * @param obj          The serial object
+ * @param char_times10 The silence that ends a frame, in tenths of a character time
+ * @param fallback     SERIAL_FRAME_IDLE or SERIAL_FRAME_EXT if there is no receiver timeout
+ * @return The SERIAL_FRAME_* mode in use
+ */
+uint8_t serial_frame_start(serial_t *obj, uint16_t char_times10, uint8_t fallback)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    serial_frame_stop(obj);
+    p_obj->frame_head = 0U;
+    p_obj->frame_tail = 0U;
+    p_obj->frame_last = serial_rx_head(obj);
+
+#if USART_RT_NUM > 0
+    if (p_obj->index < USART_RT_NUM) {
+        uint32_t bits = (serial_char_bits(obj) * char_times10 + 9U) / 10U;
+
+        USART_RT(p_obj->uart) = (USART_RT(p_obj->uart) & ~USART_RT_RT) | (bits & USART_RT_RT);
+        usart_interrupt_flag_clear(p_obj->uart, USART_INT_FLAG_RT);
+        usart_receiver_timeout_enable(p_obj->uart);
+        usart_interrupt_enable(p_obj->uart, USART_INT_RT);
+        p_obj->frame_mode = SERIAL_FRAME_RT;
+        return SERIAL_FRAME_RT;
+    }
+#else
+    (void)char_times10;
+#endif
+
+    if (fallback == SERIAL_FRAME_IDLE) {
+        usart_idle_flag_clear(p_obj);
+        usart_interrupt_enable(p_obj->uart, USART_INT_IDLE);
+    }
+    p_obj->frame_mode = fallback;
+
+    return fallback;
+}
+
+/** Stop queueing received frames
+ *
+ * @param obj The serial object
+ */
+void serial_frame_stop(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    uint8_t mode = p_obj->frame_mode;
+
+    p_obj->frame_mode = SERIAL_FRAME_OFF;
+#if USART_RT_NUM > 0
+    if (mode == SERIAL_FRAME_RT) {
+        usart_interrupt_disable(p_obj->uart, USART_INT_RT);
+        usart_receiver_timeout_disable(p_obj->uart);
+    }
+#endif
+    if ((mode == SERIAL_FRAME_IDLE) && !p_obj->rx_dma && (p_obj->idle_callback == NULL)) {
+        usart_interrupt_disable(p_obj->uart, USART_INT_IDLE);
+    }
+}
+
+/** Queue the bytes received since the last frame end as a frame. When the
+ *  queue is full they are left to the next frame.
+ *
+ * @param obj The serial object
+ */
+void serial_frame_end(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    uint16_t head = serial_rx_head(obj);
+    uint8_t fhead = p_obj->frame_head;
+
+    if ((p_obj->frame_mode == SERIAL_FRAME_OFF) || (head == p_obj->frame_last)) {
+        return;
+    }
+    if ((uint8_t)(fhead - p_obj->frame_tail) >= SERIAL_FRAME_QUEUE_SIZE) {
+        return;
+    }
+    p_obj->frame_end[fhead & (SERIAL_FRAME_QUEUE_SIZE - 1U)] = head;
+    p_obj->frame_last = head;
+    __DMB();
+    p_obj->frame_head = fhead + 1U;
+}
+
+/** Get the RX head from the DMA write position in rx_buff
+ *
+ * @param obj The serial object
+ * @return Free running head, rx_tail plus the number of bytes the DMA channel has written since
+ */
+uint16_t serial_rx_dma_head(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    uint16_t tail = p_obj->rx_tail;
+    uint32_t pos = p_obj->rx_size - dma_chan_remaining(&usart_rx_dma[p_obj->index]);
+
+    /* rx_size is a power of two, the counter reads 0 for a moment before the circular reload */
+    return (uint16_t)(tail + ((pos - tail) & (p_obj->rx_size - 1U)));
+}
+
+/** DMA full transfer interrupt of the TX channel
+ *
+ * @param param The serial object
+ * @param flags The DMA channel flags
+ */
+static void usart_tx_dma_irq(void *param, uint32_t flags)
+{
+    struct serial_s *obj_s = (struct serial_s *)param;
+
+    (void)flags;
+    dma_chan_stop(&usart_tx_dma[obj_s->index]);
+
+    /* the last frames may still be shifting out, the owner can chain the next span right away */
+    obj_s->tx_state = OP_STATE_READY;
+    if (obj_s->tx_callback != NULL) {
+        obj_s->tx_callback(obj_s);
+    }
+    /* nothing chained, release the RS-485 bus once the last frame is out */
+    if ((obj_s->de_pin != NC) && (obj_s->tx_state == OP_STATE_READY)) {
+        usart_interrupt_enable(obj_s->uart, USART_INT_TC);
+    }
+}
+
+/** Claim the TX DMA channel of the UART
+ *
+ * @param obj The serial object
+ * @return 1 if transmissions can use serial_tx_dma_transmit(), 0 otherwise
+ */
+uint8_t serial_tx_dma_start(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+    const dma_chan_t *ch;
+
+    if (p_obj->index >= UART_NUM) {
+        return 0;
+    }
+    if (p_obj->tx_dma) {
+        return 1;
+    }
+
+    ch = &usart_tx_dma[p_obj->index];
+    if (!dma_chan_attach(ch, usart_tx_dma_irq, p_obj)) {
+        return 0;
+    }
+
+    dma_chan_setup(ch, (uint32_t)&GD32_USART_TX_DATA(p_obj->uart), DMA_MEMORY_TO_PERIPHERAL, 8U, 0U,
+                   DMA_PRIORITY_MEDIUM);
+    USART_CTL2(p_obj->uart) |= USART_CTL2_DENT;
+    p_obj->tx_dma = 1U;
+
+    return 1;
+}
+
+/** Release the TX DMA channel of the UART
+ *
+ * @param obj The serial object
+ */
+void serial_tx_dma_stop(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    if (!p_obj->tx_dma) {
+        return;
+    }
+
+    USART_CTL2(p_obj->uart) &= ~USART_CTL2_DENT;
+    dma_chan_detach(&usart_tx_dma[p_obj->index]);
+
+    p_obj->tx_dma   = 0U;
+    p_obj->tx_state = OP_STATE_READY;
+}
+
+/** Begin a DMA transmission of a contiguous buffer
+ *
+ * @param obj       The serial object
+ * @param tx        The transmit buffer
+ * @param tx_length The number of bytes to transmit
+ * @return Returns number of data transfered, otherwise returns 0
+ */
+int serial_tx_dma_transmit(serial_t *obj, const void *tx, size_t tx_length)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    if (!p_obj->tx_dma || (tx_length == 0U) || serial_tx_active(obj)) {
+        return 0;
+    }
+
+    p_obj->tx_count = tx_length;
+    p_obj->tx_state = OP_STATE_BUSY_TX;
+
+    /* TC is set again by hardware once the last frame of this span is out */
+    usart_flag_clear(p_obj->uart, USART_FLAG_TC);
+    usart_de_write(p_obj, 1U);
+    dma_chan_start(&usart_tx_dma[p_obj->index], tx, tx_length, DMA_INT_FTF | DMA_INT_ERR);
+
+    return tx_length;
+}
+
+/** Check if the last frame has left the shift register
+ *
+ * @param obj The serial object
+ * @return Non-zero once the transmitter is idle
+ */
+int serial_tx_complete(serial_t *obj)
+{
+    struct serial_s *p_obj = GET_SERIAL_S(obj);
+
+    return (usart_flag_get(p_obj->uart, USART_FLAG_TC) != RESET) ? 1 : 0;
+}
+
 /** This function handles USART interrupt handler
  *
  * @param usart_periph The UART peripheral
@@ -675,6 +1532,27 @@ static void usart_irq(struct serial_s *obj_s)
         }
     }
 
+    if (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_IDLE) != RESET) {
+        usart_idle_flag_clear(obj_s);
+        usart_rx_dma_update(obj_s);
+        if (obj_s->frame_mode == SERIAL_FRAME_IDLE) {
+            serial_frame_end(obj_s);
+        }
+        if (obj_s->idle_callback != NULL) {
+            obj_s->idle_callback();
+        }
+        return;
+    }
+
+#if USART_RT_NUM > 0
+    if ((obj_s->index < USART_RT_NUM) && (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_RT) != RESET)) {
+        usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_RT);
+        usart_rx_dma_update(obj_s);
+        serial_frame_end(obj_s);
+        return;
+    }
+#endif
+
     if (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_TBE) != RESET) {
         usart_tx_interrupt(obj_s);
         return;
@@ -682,7 +1560,15 @@ static void usart_irq(struct serial_s *obj_s)
 
     if (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_TC) != RESET) {
         usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_TC);
-        usart_tx_complete_interrupt(obj_s);
+        if (obj_s->tx_dma) {
+            /* only enabled to end an RS-485 transmission, see usart_tx_dma_irq() */
+            usart_interrupt_disable(obj_s->uart, USART_INT_TC);
+            if (obj_s->tx_state == OP_STATE_READY) {
+                usart_de_write(obj_s, 0U);
+            }
+        } else {
+            usart_tx_complete_interrupt(obj_s);
+        }
         return;
     }
 
@@ -690,12 +1576,14 @@ static void usart_irq(struct serial_s *obj_s)
         /* clear ORERR error flag by reading USART DATA register */
         GD32_USART_RX_DATA(obj_s->uart);
         usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_ERR_ORERR);
+        obj_s->stats.overrun++;
     }
 
     if (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_ERR_NERR) != RESET) {
         /* clear NERR error flag by reading USART DATA register */
         GD32_USART_RX_DATA(obj_s->uart);
         usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_ERR_NERR);
+        obj_s->stats.noise++;
     }
 
     if (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_ERR_FERR) != RESET) {
@@ -703,6 +1591,7 @@ static void usart_irq(struct serial_s *obj_s)
         GD32_USART_RX_DATA(obj_s->uart);
         /* also clear it by clearing the interrupt */
         usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_ERR_FERR);
+        obj_s->stats.framing++;
     }
 
     if (usart_interrupt_flag_get(obj_s->uart, USART_INT_FLAG_PERR) != RESET) {
@@ -710,6 +1599,7 @@ static void usart_irq(struct serial_s *obj_s)
         GD32_USART_RX_DATA(obj_s->uart);
         /* also clear it by clearing the interrupt */
         usart_interrupt_flag_clear(obj_s->uart, USART_INT_FLAG_PERR);
+        obj_s->stats.parity++;
     }
 }
 
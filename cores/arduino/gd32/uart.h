@@ -113,6 +113,31 @@ typedef enum {
     ParityForced0 = 4
 } SerialParity;
 
+/* Where the end of a received frame is detected, see serial_frame_start() */
+#define SERIAL_FRAME_OFF  0   /* frame mode disabled */
+#define SERIAL_FRAME_RT   1   /* USART receiver timeout */
+#define SERIAL_FRAME_IDLE 2   /* idle line, one character time of silence */
+#define SERIAL_FRAME_EXT  3   /* the owner calls serial_frame_end(), e.g. from a timer */
+
+/* Number of complete frames that can be queued, a power of two */
+#ifndef SERIAL_FRAME_QUEUE_SIZE
+#define SERIAL_FRAME_QUEUE_SIZE 8
+#endif
+
+/* Per port counters, read through HardwareSerial::stats() */
+typedef struct {
+    uint32_t rx_bytes;      /* bytes received */
+    uint32_t tx_bytes;      /* bytes shifted out */
+    uint32_t rx_overflow;   /* received bytes lost because the RX ring was full */
+    uint32_t tx_dropped;    /* bytes dropped by the TX overflow policy */
+    uint32_t overrun;       /* hardware overrun errors */
+    uint32_t framing;       /* framing errors */
+    uint32_t parity;        /* parity errors */
+    uint32_t noise;         /* noise errors */
+    uint16_t rx_peak;       /* highest RX ring occupancy */
+    uint16_t tx_peak;       /* highest TX ring occupancy */
+} serial_stats_t;
+
 typedef struct serial_s serial_t;
 
 struct serial_s {
@@ -135,6 +160,8 @@ struct serial_s {
     //used in HardwareSerial
     uint8_t         *rx_buff;
     uint8_t         *tx_buff;
+    uint16_t   rx_buff_size;
+    uint16_t   tx_buff_size;
     uint16_t   tx_count;
     uint16_t   rx_count;
 
@@ -144,9 +171,41 @@ struct serial_s {
     volatile uint16_t tx_tail;
 
     uint32_t   error_code;
+    serial_stats_t stats;
     operation_state_enum  tx_state;
     operation_state_enum  rx_state;
 
+    /* rx_buff is filled by a circular DMA channel, rx_head follows its counter */
+    uint8_t    rx_dma;
+    /* transmission goes through DMA, tx_count holds the length of the running span */
+    uint8_t    tx_dma;
+
+    /* notifications from the RX interrupt, see serial_char_match() and serial_idle_notify();
+       receive_callback runs whenever bytes have been added to rx_buff */
+    uint8_t    char_match;
+    uint16_t   rx_match;
+    void (*match_callback)(void);
+    void (*idle_callback)(void);
+    void (*receive_callback)(void);
+
+    /* frame mode: free running rx_buff positions where received frames end */
+    uint8_t    frame_mode;
+    volatile uint8_t frame_head;
+    volatile uint8_t frame_tail;
+    uint16_t   frame_last;
+    uint16_t   frame_end[SERIAL_FRAME_QUEUE_SIZE];
+
+    /* flow control pins, NC when unused. rts_hw is set when the USART drives rts_pin,
+       rts_held while the RX ring is above its high-water mark */
+    PinName    rts_pin;
+    PinName    cts_pin;
+    uint8_t    rts_hw;
+    uint8_t    rts_held;
+
+    /* RS-485 driver enable pin and its active level, NC when unused */
+    PinName    de_pin;
+    uint8_t    de_level;
+
     void (*tx_callback)(serial_t *obj);
     void (*rx_callback)(serial_t *obj);
 };
@@ -202,6 +261,58 @@ void uart_attach_rx_callback(serial_t *obj, void (*callback)(serial_t *));
 int serial_transmit(serial_t *obj, const void *tx, size_t tx_length);
 /* Begin asynchronous RX transfer (enable interrupt for data collecting). */
 void serial_receive(serial_t *obj, void *rx, size_t rx_length);
+/* Start circular DMA reception into rx_buff. Returns 0 if the UART has no free DMA channel. */
+uint8_t serial_rx_dma_start(serial_t *obj, uint16_t size);
+/* Stop circular DMA reception. */
+void serial_rx_dma_stop(serial_t *obj);
+/* Free running RX head derived from the DMA write position in rx_buff. */
+uint16_t serial_rx_dma_head(serial_t *obj);
+/* Claim the TX DMA channel. Returns 0 if the UART has no free DMA channel. */
+uint8_t serial_tx_dma_start(serial_t *obj);
+/* Release the TX DMA channel. */
+void serial_tx_dma_stop(serial_t *obj);
+/* Begin a DMA transmission of a contiguous buffer, tx_callback runs when the DMA is done. */
+int serial_tx_dma_transmit(serial_t *obj, const void *tx, size_t tx_length);
+/* Check if the last frame has left the shift register. */
+int serial_tx_complete(serial_t *obj);
+
+/* Call callback once c has been received, SERIAL_RESERVED_CHAR_MATCH or NULL disables it. */
+void serial_char_match(serial_t *obj, uint8_t c, void (*callback)(void));
+/* Call callback when the RX line goes idle, NULL disables it. */
+void serial_idle_notify(serial_t *obj, void (*callback)(void));
+
+/* Set up RTS/CTS flow control, call before serial_enable(). NC leaves a line unused. */
+uint8_t serial_flow_control(serial_t *obj, PinName rts, PinName cts);
+/* Drop RTS above the RX ring high-water mark and raise it again below the low-water mark. */
+void serial_rts_update(serial_t *obj);
+
+/* 9-bit multi-drop bus: stay mute until an address mark for addr arrives. */
+void serial_multidrop(serial_t *obj, uint8_t addr);
+/* Ignore the bus until the next address mark for this node. */
+void serial_mute(serial_t *obj);
+/* Send an address mark. */
+void serial_send_address(serial_t *obj, uint8_t addr);
+
+/* Drive de to level while transmitting, NC disables it. */
+void serial_rs485(serial_t *obj, PinName de, uint8_t level);
+
+/* Queue received frames that end after char_times10 / 10 character times of silence.
+   Uses the receiver timeout where the USART has one, fallback otherwise. Returns the SERIAL_FRAME_* mode in use. */
+uint8_t serial_frame_start(serial_t *obj, uint16_t char_times10, uint8_t fallback);
+/* Leave frame mode. */
+void serial_frame_stop(serial_t *obj);
+/* Close the frame received so far. */
+void serial_frame_end(serial_t *obj);
+/* Measure the rate of the next received character and switch to it, returns 0 on timeout. */
+uint32_t serial_autobaud(serial_t *obj, uint32_t timeout);
+/* Number of bits in one character, start and stop bits included. */
+uint32_t serial_char_bits(serial_t *obj);
+
+/* Write position of the RX ring, read straight from the DMA counter in DMA mode */
+static inline uint16_t serial_rx_head(serial_t *obj)
+{
+    return obj->rx_dma ? serial_rx_dma_head(obj) : obj->rx_head;
+}
 
 #ifdef __cplusplus
 }
@@ -61,6 +61,9 @@ int main(void)
 
     while (1) {
         loop();
+        if (serialEventRun) {
+            serialEventRun();
+        }
     }
     return 0;
 }
@@ -0,0 +1,30 @@
+/*
+  BinaryLogBasic
+
+  Logs an analog reading every 10 ms without formatting any text on the
+  target. Decode the output on the host with
+
+    python3 extras/binlog_decode.py BinaryLogBasic.ino.elf /dev/ttyUSB0
+*/
+
+#include <BinaryLog.h>
+
+static uint8_t logBuffer[1024];
+BinaryLog logger(Serial1, logBuffer, sizeof(logBuffer));
+
+void setup()
+{
+    Serial1.begin(115200);
+    BINLOG(logger, "boot, core clock %lu Hz\n", SystemCoreClock);
+}
+
+void loop()
+{
+    static uint32_t last;
+
+    if (millis() - last >= 10) {
+        last = millis();
+        BINLOG(logger, "t=%lu ms adc=%d dropped=%lu", last, analogRead(A0), logger.dropped());
+    }
+    logger.drain();
+}
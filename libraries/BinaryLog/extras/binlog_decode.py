@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Turn a BinaryLog stream back into text.
+
+The format strings are read from the sketch ELF file, a record refers to its
+format string by address:
+
+    binlog_decode.py sketch.elf /dev/ttyUSB0 --baud 115200
+    binlog_decode.py sketch.elf capture.bin
+
+A port needs pyserial, a file (or - for stdin) is read as is.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+HEADER = 6
+
+SPEC = re.compile(r"%([-+ #0]*)(\d*|\*)(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t|L)?([diouxXcsfFeEgGp%])")
+
+
+class Elf:
+    """The loadable sections of a little endian 32-bit ELF file."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s is not a little endian 32-bit ELF file" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (name, type_, flags, addr, offset, size) = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            # SHT_PROGBITS sections with SHF_ALLOC
+            if type_ == 1 and flags & 0x2 and size:
+                self.sections.append((addr, size, offset))
+
+    def string(self, addr):
+        for start, size, offset in self.sections:
+            if start <= addr < start + size:
+                begin = offset + addr - start
+                end = self.data.find(b"\0", begin, offset + size)
+                if end < 0:
+                    return None
+                return self.data[begin:end].decode("latin-1")
+        return None
+
+
+def render(fmt, args):
+    """Format the record arguments as the format string describes them."""
+    out = []
+    pos = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        # each * width or precision was recorded as an int ahead of the value
+        stars = []
+        for field in (width, prec):
+            if field == "*":
+                if len(args) < 4:
+                    break
+                stars.append(struct.unpack("<i", args[:4])[0])
+                args = args[4:]
+        if len(stars) != (width == "*") + (prec == "*"):
+            out.append("<cut>")
+            break
+        # a corrupt record must not ask for megabytes of padding
+        stars = [max(-255, min(255, v)) for v in stars]
+        if prec == "*" and stars[-1] < 0:
+            # as in C, a negative precision is taken as if it were omitted
+            prec = None
+            stars.pop()
+        if conv == "s":
+            if len(args) < 1 or len(args) < 1 + args[0]:
+                out.append("<cut>")
+                break
+            n = args[0]
+            value = args[1:1 + n].decode("latin-1")
+            args = args[1 + n:]
+        else:
+            size = 8 if length == "ll" and conv not in "fFeEgG" else 4
+            if len(args) < size:
+                out.append("<cut>")
+                break
+            raw, args = args[:size], args[size:]
+            if conv in "fFeEgG":
+                value, = struct.unpack("<f", raw)
+            elif conv in "di":
+                value, = struct.unpack("<q" if size == 8 else "<i", raw)
+            else:
+                value, = struct.unpack("<Q" if size == 8 else "<I", raw)
+        spec = "%" + flags + width + ("." + prec if prec else "")
+        if conv == "p":
+            out.append("0x%08x" % value)
+        elif conv == "u":
+            out.append((spec + "d") % tuple(stars + [value]))
+        elif conv == "c":
+            out.append((spec + "c") % tuple(stars + [chr(value & 0xFF)]))
+        else:
+            out.append((spec + conv) % tuple(stars + [value]))
+    else:
+        out.append(fmt[pos:])
+    return "".join(out)
+
+
+def records(stream, elf):
+    """Yield decoded lines, resynchronizing on BINLOG_SYNC after garbage."""
+    buf = bytearray()
+    while True:
+        chunk = stream.read(getattr(stream, "in_waiting", 256) or 1)
+        if not chunk:
+            return
+        buf += chunk
+        while len(buf) >= HEADER:
+            if buf[0] != SYNC:
+                del buf[0]
+                continue
+            length = buf[1]
+            addr, = struct.unpack_from("<I", buf, 2)
+            fmt = elf.string(addr) if length >= HEADER else None
+            if fmt is None:
+                del buf[0]
+                continue
+            if len(buf) < length:
+                break
+            yield render(fmt, bytes(buf[HEADER:length]))
+            del buf[:length]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="sketch ELF file the log was produced by")
+    parser.add_argument("source", help="serial port, capture file or - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    opts = parser.parse_args()
+
+    elf = Elf(opts.elf)
+    if opts.source == "-":
+        stream = sys.stdin.buffer
+    elif opts.source.startswith(("/dev/", "COM")):
+        import serial
+        stream = serial.Serial(opts.source, opts.baud, timeout=None)
+    else:
+        stream = open(opts.source, "rb")
+
+    for line in records(stream, elf):
+        sys.stdout.write(line if line.endswith("\n") else line + "\n")
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+/*
+  BinaryLog.cpp - Deferred binary logging over a Print
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "BinaryLog.h"
+
+void BinaryLog::_push(const uint8_t *rec, size_t n)
+{
+    serial_ring_t ring(_buffer, _size, _head, _tail);
+    uint32_t primask = __get_PRIMASK();
+    uint8_t *span;
+    size_t room;
+
+    // several producers (loop() and interrupts) share the head
+    __disable_irq();
+    if (ring.availableForWrite() < n) {
+        _dropped++;
+        __set_PRIMASK(primask);
+        return;
+    }
+    room = ring.writeSpan(&span);
+    if (room > n) {
+        room = n;
+    }
+    memcpy(span, rec, room);
+    ring.commit(room);
+    if (room < n) {
+        ring.writeSpan(&span);
+        memcpy(span, rec + room, n - room);
+        ring.commit(n - room);
+    }
+    __set_PRIMASK(primask);
+}
+
+size_t BinaryLog::drain(void)
+{
+    serial_ring_t ring(_buffer, _size, _head, _tail);
+    const uint8_t *span;
+    size_t written = 0;
+    size_t count, room;
+
+    while ((count = ring.readSpan(&span)) > 0) {
+        room = _port.availableForWrite();
+        if (room == 0) {
+            // a Print without availableForWrite() always reports 0, give it a
+            // bounded blocking write once per call so the ring still drains
+            if (written != 0) {
+                break;
+            }
+            room = BINLOG_DRAIN_CHUNK;
+        }
+        if (count > room) {
+            count = room;
+        }
+        count = _port.write(span, count);
+        if (count == 0) {
+            break;
+        }
+        ring.consume(count);
+        written += count;
+    }
+    return written;
+}
@@ -0,0 +1,179 @@
+/*
+  BinaryLog.h - Deferred binary logging over a Print
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef BinaryLog_h
+#define BinaryLog_h
+
+#include <Arduino.h>
+#include <type_traits>
+
+// Largest record, header included. Longer records are cut at an argument.
+#if !defined(BINLOG_RECORD_MAX)
+#define BINLOG_RECORD_MAX 64
+#endif
+// Bytes of a %s argument that are kept
+#if !defined(BINLOG_STRING_MAX)
+#define BINLOG_STRING_MAX 32
+#endif
+// Bytes drain() hands over per call to a port that reports no room
+#if !defined(BINLOG_DRAIN_CHUNK)
+#define BINLOG_DRAIN_CHUNK 16
+#endif
+
+// First byte of every record
+#define BINLOG_SYNC 0xA5
+// Set in the record length while packing once an argument did not fit
+#define BINLOG_CUT  0x8000U
+
+// Log a printf style message, e.g. BINLOG(logger, "adc %u at %lu ms", value, millis()).
+// Only the address of fmt and the raw arguments are stored; the text is
+// rebuilt on the host by extras/binlog_decode.py from the sketch ELF file.
+#define BINLOG(log, fmt, ...) (log).record(fmt, ##__VA_ARGS__)
+
+// A record on the wire is
+//   BINLOG_SYNC, length of the whole record, format string address (4 bytes)
+// followed by the arguments, little endian: 4 bytes for integers up to 32 bits,
+// pointers and chars, 8 bytes for 64-bit integers, a 4-byte float for float
+// and double, and a length byte plus up to BINLOG_STRING_MAX bytes for
+// strings. A * width or precision is an int argument of its own, stored
+// ahead of the value. The decoder takes the argument layout from the format
+// string.
+//
+// record() may be called from interrupts. It copies the record into the ring
+// with interrupts off for the duration of a memcpy, or drops it (counted in
+// dropped()) when the ring is full. drain() moves what the port can take
+// without blocking and belongs in loop(). That relies on the port overriding
+// availableForWrite(), as HardwareSerial does. When the port reports no room,
+// which the default Print::availableForWrite() always does, drain() writes up
+// to BINLOG_DRAIN_CHUNK bytes anyway and may block until the port takes them.
+static_assert(BINLOG_RECORD_MAX <= 255, "the record length is a single byte");
+static_assert(BINLOG_STRING_MAX <= 255, "the string length is a single byte");
+
+class BinaryLog
+{
+    public:
+        // size is rounded down to a power of two
+        BinaryLog(Print &port, uint8_t *buffer, uint16_t size)
+            : _port(port), _buffer(buffer), _size(serial_ring_t::fit(size)),
+              _head(0), _tail(0), _dropped(0)
+        {
+        }
+
+        // Arguments are taken by reference, a String is packed from its own
+        // buffer and never copied to the heap
+        template <typename... Args>
+        void record(const char *fmt, const Args &... args)
+        {
+            uint8_t rec[BINLOG_RECORD_MAX];
+            size_t n = 6;
+            uint32_t id = (uint32_t)(uintptr_t)fmt;
+
+            _pack(rec, n, args...);
+            n &= ~BINLOG_CUT;
+            rec[0] = BINLOG_SYNC;
+            rec[1] = (uint8_t)n;
+            memcpy(&rec[2], &id, 4);
+            _push(rec, n);
+        }
+
+        // Hand queued records to the port, returns the bytes written
+        size_t drain(void);
+        // Bytes waiting in the ring
+        uint16_t pending(void)
+        {
+            return (uint16_t)(_head - _tail);
+        }
+        uint32_t dropped(void)
+        {
+            return _dropped;
+        }
+
+    private:
+        void _push(const uint8_t *rec, size_t n);
+
+        static void _put(uint8_t *rec, size_t &n, const void *v, size_t size)
+        {
+            // once an argument is cut the later ones are dropped as well
+            if ((n & BINLOG_CUT) || (n + size > BINLOG_RECORD_MAX)) {
+                n |= BINLOG_CUT;
+                return;
+            }
+            memcpy(&rec[n], v, size);
+            n += size;
+        }
+        // integers, bools and enums: 8 bytes above 32 bits, 4 bytes otherwise
+        template <typename T>
+        static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+        _arg(uint8_t *rec, size_t &n, T v)
+        {
+            if (sizeof(T) > 4) {
+                uint64_t w = (uint64_t)v;
+                _put(rec, n, &w, 8);
+            } else {
+                uint32_t w = (uint32_t)v;
+                _put(rec, n, &w, 4);
+            }
+        }
+        static void _arg(uint8_t *rec, size_t &n, double v)
+        {
+            float f = (float)v;
+            _put(rec, n, &f, 4);
+        }
+        static void _arg(uint8_t *rec, size_t &n, const void *v)
+        {
+            uint32_t w = (uint32_t)(uintptr_t)v;
+            _put(rec, n, &w, 4);
+        }
+        static void _arg(uint8_t *rec, size_t &n, const char *s)
+        {
+            uint8_t len = s ? strnlen(s, BINLOG_STRING_MAX) : 0;
+
+            if ((n & BINLOG_CUT) || (n + 1 + len > BINLOG_RECORD_MAX)) {
+                n |= BINLOG_CUT;
+                return;
+            }
+            rec[n++] = len;
+            memcpy(&rec[n], s, len);
+            n += len;
+        }
+        static void _arg(uint8_t *rec, size_t &n, const String &s)
+        {
+            _arg(rec, n, s.c_str());
+        }
+
+        static void _pack(uint8_t *rec, size_t &n)
+        {
+            (void)rec;
+            (void)n;
+        }
+        template <typename T, typename... Args>
+        static void _pack(uint8_t *rec, size_t &n, const T &first, const Args &... rest)
+        {
+            _arg(rec, n, first);
+            _pack(rec, n, rest...);
+        }
+
+        Print &_port;
+        uint8_t *_buffer;
+        uint16_t _size;
+        volatile uint16_t _head;
+        volatile uint16_t _tail;
+        volatile uint32_t _dropped;
+};
+
+#endif
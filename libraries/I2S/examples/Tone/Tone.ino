@@ -0,0 +1,47 @@
+/*
+  Tone
+
+  Plays a 1 kHz sine on both channels of a 48 kHz, 16-bit I2S DAC such as
+  a PCM5102 on SPI1 (SD PB15, WS PB12, CK PB13).
+
+  The buffer holds a whole number of sine periods, so the DMA loops over it
+  and the half callback has nothing to do; it only counts. A player would
+  copy the next block of samples into the half it is given.
+*/
+
+#include <I2S.h>
+
+#define RATE    48000
+#define FREQ    1000
+#define FRAMES  (RATE / FREQ * 4)
+
+I2SClass i2s(PB15, PB12, PB13);
+int16_t samples[FRAMES * 2];
+volatile uint32_t halves;
+
+void onHalf(void *half, size_t bytes)
+{
+    (void)half;
+    (void)bytes;
+    halves++;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    for (int i = 0; i < FRAMES; i++) {
+        int16_t s = (int16_t)(16000 * sin(2 * PI * FREQ * i / RATE));
+        samples[2 * i] = s;
+        samples[2 * i + 1] = s;
+    }
+    if (!i2s.begin(I2S_TRANSMIT, RATE, 16) || !i2s.start(samples, sizeof(samples), onHalf)) {
+        Serial.println("I2S not available on these pins");
+    }
+}
+
+void loop()
+{
+    delay(1000);
+    Serial.print(halves);
+    Serial.println(" half buffers played");
+}
@@ -0,0 +1,95 @@
+/*
+  I2S.cpp - I2S audio streaming on the SPI peripherals
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "I2S.h"
+
+static const uint32_t i2s_standards[] = {
+    I2S_STD_PHILLIPS, I2S_STD_MSB, I2S_STD_LSB, I2S_STD_PCMSHORT, I2S_STD_PCMLONG
+};
+
+I2SClass::I2SClass(uint32_t sdPin, uint32_t wsPin, uint32_t ckPin)
+    : _begun(false), _frame_bytes(4), _on_half(NULL)
+{
+    _i2s.spi = (SPIName)NC;
+    _i2s.pin_sd = DIGITAL_TO_PINNAME(sdPin);
+    _i2s.pin_ws = DIGITAL_TO_PINNAME(wsPin);
+    _i2s.pin_ck = DIGITAL_TO_PINNAME(ckPin);
+    _i2s.pin_mck = NC;
+    _i2s.running = 0;
+}
+
+bool I2SClass::begin(uint8_t direction, uint32_t sampleRate, uint8_t bitsPerSample, uint8_t mode)
+{
+    uint32_t format;
+
+    switch (bitsPerSample) {
+        case 16:
+            format = I2S_FRAMEFORMAT_DT16B_CH16B;
+            break;
+        case 24:
+            format = I2S_FRAMEFORMAT_DT24B_CH32B;
+            break;
+        case 32:
+            format = I2S_FRAMEFORMAT_DT32B_CH32B;
+            break;
+        default:
+            return false;
+    }
+    if ((mode > I2S_PCM_LONG_MODE) || (sampleRate == 0)) {
+        return false;
+    }
+    end();
+    if (!i2s_begin(&_i2s, direction == I2S_RECEIVE, sampleRate, i2s_standards[mode], format)) {
+        return false;
+    }
+    // a stereo frame: two channels of one or two halfwords
+    _frame_bytes = (bitsPerSample == 16) ? 4 : 8;
+    _begun = true;
+    return true;
+}
+
+void I2SClass::end(void)
+{
+    if (!_begun) {
+        return;
+    }
+    i2s_free(&_i2s);
+    _begun = false;
+}
+
+bool I2SClass::start(void *buffer, size_t bytes, void (*onHalf)(void *half, size_t bytes))
+{
+    if (!_begun || (onHalf == NULL) || (bytes > 0x1FFFE) || (bytes == 0) ||
+            (bytes % (2 * _frame_bytes) != 0)) {
+        return false;
+    }
+    _on_half = onHalf;
+    return i2s_stream_start(&_i2s, (uint16_t *)buffer, bytes / 2, _half, this) != 0;
+}
+
+void I2SClass::stop(void)
+{
+    i2s_stream_stop(&_i2s);
+}
+
+void I2SClass::_half(void *param, uint16_t *half, uint16_t len)
+{
+    I2SClass *i2s = (I2SClass *)param;
+
+    i2s->_on_half(half, (size_t)len * 2);
+}
@@ -0,0 +1,86 @@
+/*
+  I2S.h - I2S audio streaming on the SPI peripherals
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef I2S_h
+#define I2S_h
+
+#include <Arduino.h>
+
+#if !defined(GD32F30x) && !defined(GD32E50X) && \
+    !defined(GD32F10X_HD) && !defined(GD32F10X_XD) && !defined(GD32F10X_CL)
+#error "I2S is only available on GD32F30x, GD32E50x and GD32F10x HD/XD/CL parts"
+#endif
+
+#include "utility/drv_i2s.h"
+
+// Direction of the stream, the interface is always the clock master
+#define I2S_TRANSMIT 0
+#define I2S_RECEIVE  1
+
+// Framing standards
+#define I2S_PHILIPS_MODE         0
+#define I2S_LEFT_JUSTIFIED_MODE  1   // MSB justified
+#define I2S_RIGHT_JUSTIFIED_MODE 2   // LSB justified
+#define I2S_PCM_SHORT_MODE       3
+#define I2S_PCM_LONG_MODE        4
+
+// The pins are the MOSI (SD), NSS (WS) and SCK (CK) pins of SPI1 or SPI2.
+//
+// Samples are streamed by DMA through a circular buffer split in two halves:
+// each time the DMA leaves a half, onHalf runs from the DMA interrupt with
+// that half, to be refilled for playback or read for capture, while the DMA
+// works on the other one. Nothing runs per sample.
+//
+// Left and right samples alternate in the buffer. 16-bit samples are int16_t;
+// 24 and 32-bit samples are two halfwords each, the high half first.
+class I2SClass
+{
+    public:
+        I2SClass(uint32_t sdPin, uint32_t wsPin, uint32_t ckPin);
+
+        // Drive MCK, 256 times the sample rate, on the I2S MCK pin. Call before begin().
+        void setMasterClock(uint32_t mckPin)
+        {
+            _i2s.pin_mck = DIGITAL_TO_PINNAME(mckPin);
+        }
+        // bitsPerSample is 16, 24 or 32. Returns false if the pins are not
+        // on an SPI with an I2S mode.
+        bool begin(uint8_t direction, uint32_t sampleRate, uint8_t bitsPerSample = 16,
+                   uint8_t mode = I2S_PHILIPS_MODE);
+        void end(void);
+
+        // Stream until stop(). bytes holds a whole number of stereo frames in
+        // each half and is at most 131070. For playback fill the whole buffer
+        // before the call. Returns false if the DMA channel is taken.
+        bool start(void *buffer, size_t bytes, void (*onHalf)(void *half, size_t bytes));
+        void stop(void);
+        bool running(void) const
+        {
+            return _i2s.running != 0;
+        }
+
+    private:
+        static void _half(void *param, uint16_t *half, uint16_t len);
+
+        i2s_t _i2s;
+        bool _begun;
+        uint8_t _frame_bytes;
+        void (*_on_half)(void *half, size_t bytes);
+};
+
+#endif
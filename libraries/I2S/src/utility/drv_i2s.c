@@ -0,0 +1,265 @@
+/*
+    Copyright (c) 2020, GigaDevice Semiconductor Inc.
+
+    Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its contributors
+       may be used to endorse or promote products derived from this software without
+       specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+OF SUCH DAMAGE.
+*/
+
+#include "drv_i2s.h"
+#include "pinmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* on GD32F10x only the HD, XD and CL parts have the I2S mode */
+#if defined(GD32F30x) || defined(GD32E50X) || \
+    defined(GD32F10X_HD) || defined(GD32F10X_XD) || defined(GD32F10X_CL)
+
+#define I2S_S(obj)           ((struct i2s_s *)(obj))
+#define I2S_PINS_FREE_MODE   0x00000001
+#define I2S_DMA_NUM          2
+
+/* DMA request lines of SPI1 and SPI2, the SPIs with an I2S mode */
+static const dma_chan_t i2s_rx_dma[I2S_DMA_NUM] = {
+    {DMA0, DMA_CH3},
+#if defined(DMA_HAS_DMA1)
+    {DMA1, DMA_CH0},
+#else
+    {0U, DMA_CH0},
+#endif
+};
+
+static const dma_chan_t i2s_tx_dma[I2S_DMA_NUM] = {
+    {DMA0, DMA_CH4},
+#if defined(DMA_HAS_DMA1)
+    {DMA1, DMA_CH1},
+#else
+    {0U, DMA_CH1},
+#endif
+};
+
+/** Get the slot of an SPI in the DMA channel tables
+ *
+ * @param spi The SPI peripheral
+ * @return The slot, or I2S_DMA_NUM if the SPI has no I2S mode
+ */
+static uint8_t i2s_dma_slot(SPIName spi)
+{
+    switch ((int)spi) {
+        case SPI1:
+            return 0;
+#ifdef SPI2
+        case SPI2:
+            return 1;
+#endif
+        default:
+            return I2S_DMA_NUM;
+    }
+}
+
+/** Configure the SD pin of a receiver as an input
+ *
+ * The pin maps select AF push-pull, which would drive the data line, so
+ * only the remap is taken from the map.
+ * @param pin The SD pin
+ */
+static void i2s_input_pinout(PinName pin)
+{
+    int function = (int)pinmap_function(pin, PinMap_SPI_MOSI);
+
+    function &= ~(PIN_MODE_MASK << PIN_MODE_SHIFT);
+    function |= PIN_MODE_IN_FLOATING << PIN_MODE_SHIFT;
+    pin_function(pin, function);
+}
+
+/** Initialize the SPI of the pins as an I2S master
+ *
+ * @param obj      The I2S object, with its pins set
+ * @param receive  Non-zero to capture, zero to play
+ * @param rate     Sample rate in Hz
+ * @param standard I2S_STD_PHILLIPS, I2S_STD_MSB, I2S_STD_LSB, I2S_STD_PCMSHORT or I2S_STD_PCMLONG
+ * @param format   One of the I2S_FRAMEFORMAT_* data and channel lengths
+ * @return 1 on success, 0 if the pins are not on an SPI with an I2S mode
+ */
+uint8_t i2s_begin(i2s_t *obj, uint8_t receive, uint32_t rate, uint32_t standard, uint32_t format)
+{
+    struct i2s_s *i2sobj = I2S_S(obj);
+    SPIName spi_sd = (SPIName)pinmap_peripheral(i2sobj->pin_sd, PinMap_SPI_MOSI);
+    SPIName spi_ck = (SPIName)pinmap_peripheral(i2sobj->pin_ck, PinMap_SPI_SCLK);
+    SPIName spi_ws = (SPIName)pinmap_peripheral(i2sobj->pin_ws, PinMap_SPI_SSEL);
+    uint8_t index;
+
+    i2sobj->spi = (SPIName)pinmap_merge(pinmap_merge(spi_sd, spi_ck), spi_ws);
+    index = i2s_dma_slot(i2sobj->spi);
+    if ((index >= I2S_DMA_NUM) || (i2s_tx_dma[index].periph == 0U)) {
+        return 0;
+    }
+    i2sobj->dma_index = index;
+    i2sobj->receive = receive;
+    i2sobj->running = 0U;
+
+    if (i2sobj->spi == SPI1) {
+        rcu_periph_clock_enable(RCU_SPI1);
+    }
+#ifdef SPI2
+    if (i2sobj->spi == SPI2) {
+        rcu_periph_clock_enable(RCU_SPI2);
+    }
+#endif
+
+    pinmap_pinout(i2sobj->pin_ck, PinMap_SPI_SCLK);
+    pinmap_pinout(i2sobj->pin_ws, PinMap_SPI_SSEL);
+    if (receive) {
+        i2s_input_pinout(i2sobj->pin_sd);
+    } else {
+        pinmap_pinout(i2sobj->pin_sd, PinMap_SPI_MOSI);
+    }
+    /* MCK is on a fixed pin without remap */
+    if (i2sobj->pin_mck != NC) {
+        pin_function(i2sobj->pin_mck, GD_PIN_FUNCTION1(PIN_MODE_AF_PP, 0));
+    }
+
+    spi_i2s_deinit(i2sobj->spi);
+    i2s_init(i2sobj->spi, receive ? I2S_MODE_MASTERRX : I2S_MODE_MASTERTX, standard, I2S_CKPL_LOW);
+    i2s_psc_config(i2sobj->spi, rate, format,
+                   (i2sobj->pin_mck != NC) ? I2S_MCKOUT_ENABLE : I2S_MCKOUT_DISABLE);
+    return 1;
+}
+
+/** Stop streaming and release the SPI and its pins
+ *
+ * @param obj The I2S object
+ */
+void i2s_free(i2s_t *obj)
+{
+    struct i2s_s *i2sobj = I2S_S(obj);
+
+    i2s_stream_stop(obj);
+    spi_i2s_deinit(i2sobj->spi);
+    if (i2sobj->spi == SPI1) {
+        rcu_periph_clock_disable(RCU_SPI1);
+    }
+#ifdef SPI2
+    if (i2sobj->spi == SPI2) {
+        rcu_periph_clock_disable(RCU_SPI2);
+    }
+#endif
+    pin_function(i2sobj->pin_sd, I2S_PINS_FREE_MODE);
+    pin_function(i2sobj->pin_ck, I2S_PINS_FREE_MODE);
+    pin_function(i2sobj->pin_ws, I2S_PINS_FREE_MODE);
+    if (i2sobj->pin_mck != NC) {
+        pin_function(i2sobj->pin_mck, I2S_PINS_FREE_MODE);
+    }
+}
+
+/** DMA interrupt: hand the half the DMA has left to the callback
+ *
+ * @param param The I2S object
+ * @param flags The channel flags
+ */
+static void i2s_dma_irq(void *param, uint32_t flags)
+{
+    struct i2s_s *i2sobj = I2S_S(param);
+    uint16_t half = i2sobj->len / 2U;
+
+    if (flags & DMA_CHAN_FLAG_ERR) {
+        i2s_stream_stop((i2s_t *)param);
+        return;
+    }
+    /* both flags at once mean the interrupt came late, the first half is older */
+    if (flags & DMA_CHAN_FLAG_HTF) {
+        i2sobj->callback(i2sobj->param, i2sobj->buffer, half);
+    }
+    if (flags & DMA_CHAN_FLAG_FTF) {
+        i2sobj->callback(i2sobj->param, i2sobj->buffer + half, half);
+    }
+}
+
+/** Stream through a circular buffer until i2s_stream_stop()
+ *
+ * The DMA runs over buffer for good; each time it crosses the middle or
+ * wraps, callback gets the half it just left. A transmitter's buffer must
+ * hold the first samples of both halves before the call.
+ * @param obj      The I2S object
+ * @param buffer   Samples, two halfwords per 24 or 32-bit sample
+ * @param len      Size of buffer in halfwords, even
+ * @param callback Half buffer callback, run from the DMA interrupt
+ * @param param    Passed back to the callback
+ * @return 1 if streaming started, 0 if the DMA channel is taken or len is odd
+ */
+uint8_t i2s_stream_start(i2s_t *obj, uint16_t *buffer, uint16_t len, i2s_callback_t callback, void *param)
+{
+    struct i2s_s *i2sobj = I2S_S(obj);
+    const dma_chan_t *ch;
+
+    if (i2sobj->running || (len < 2U) || (len & 1U) || (callback == NULL)) {
+        return 0;
+    }
+    ch = i2sobj->receive ? &i2s_rx_dma[i2sobj->dma_index] : &i2s_tx_dma[i2sobj->dma_index];
+    if (!dma_chan_attach(ch, i2s_dma_irq, obj)) {
+        return 0;
+    }
+    i2sobj->buffer = buffer;
+    i2sobj->len = len;
+    i2sobj->callback = callback;
+    i2sobj->param = param;
+
+    dma_chan_setup(ch, (uint32_t)&SPI_DATA(i2sobj->spi),
+                   i2sobj->receive ? DMA_PERIPHERAL_TO_MEMORY : DMA_MEMORY_TO_PERIPHERAL,
+                   16U, 1U, DMA_PRIORITY_HIGH);
+    dma_chan_start(ch, buffer, len, DMA_INT_HTF | DMA_INT_FTF | DMA_INT_ERR);
+    spi_dma_enable(i2sobj->spi, i2sobj->receive ? SPI_DMA_RECEIVE : SPI_DMA_TRANSMIT);
+    i2sobj->running = 1U;
+    i2s_enable(i2sobj->spi);
+    return 1;
+}
+
+/** Stop streaming and release the DMA channel
+ *
+ * @param obj The I2S object
+ */
+void i2s_stream_stop(i2s_t *obj)
+{
+    struct i2s_s *i2sobj = I2S_S(obj);
+    const dma_chan_t *ch;
+
+    if (!i2sobj->running) {
+        return;
+    }
+    ch = i2sobj->receive ? &i2s_rx_dma[i2sobj->dma_index] : &i2s_tx_dma[i2sobj->dma_index];
+    spi_dma_disable(i2sobj->spi, i2sobj->receive ? SPI_DMA_RECEIVE : SPI_DMA_TRANSMIT);
+    dma_chan_detach(ch);
+    if (!i2sobj->receive) {
+        /* let the sample already in the data register out */
+        while (RESET == spi_i2s_flag_get(i2sobj->spi, I2S_FLAG_TBE));
+    }
+    i2s_disable(i2sobj->spi);
+    i2sobj->running = 0U;
+}
+
+#endif /* GD32F30x || GD32E50X || GD32F10X_HD || GD32F10X_XD || GD32F10X_CL */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2020, GigaDevice Semiconductor Inc.
+
+    Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its contributors
+       may be used to endorse or promote products derived from this software without
+       specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+OF SUCH DAMAGE.
+*/
+
+#ifndef __DRV_I2S_H
+#define __DRV_I2S_H
+
+#include "PinNames.h"
+#include "PeripheralPins.h"
+#include "PeripheralNames.h"
+#include "dma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Called from the DMA interrupt with the half of the stream buffer that
+ * the DMA has just left: played out for a transmitter, freshly filled for
+ * a receiver. len is in halfwords. */
+typedef void (*i2s_callback_t)(void *param, uint16_t *half, uint16_t len);
+
+struct i2s_s {
+    SPIName spi;
+    PinName pin_sd;
+    PinName pin_ws;
+    PinName pin_ck;
+    PinName pin_mck;
+    uint8_t receive;
+    uint8_t dma_index;
+    uint8_t running;
+    uint16_t *buffer;
+    uint16_t len;
+    i2s_callback_t callback;
+    void *param;
+};
+
+typedef struct i2s_s i2s_t;
+
+uint8_t i2s_begin(i2s_t *obj, uint8_t receive, uint32_t rate, uint32_t standard, uint32_t format);
+void i2s_free(i2s_t *obj);
+uint8_t i2s_stream_start(i2s_t *obj, uint16_t *buffer, uint16_t len, i2s_callback_t callback, void *param);
+void i2s_stream_stop(i2s_t *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DRV_I2S_H */
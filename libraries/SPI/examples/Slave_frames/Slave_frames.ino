@@ -0,0 +1,32 @@
+// SPI slave: each frame the master clocks in between NSS low and high is
+// received by DMA, then echoed back to it in the following frame.
+#include <SPI.h>
+
+#define FRAME_SIZE 64
+
+uint8_t frames[2 * FRAME_SIZE];
+uint8_t reply[FRAME_SIZE];
+volatile uint32_t frame_count = 0;
+
+// runs in an interrupt, the next frame is already being received
+void onFrame(const uint8_t *data, size_t len)
+{
+    memcpy(reply, data, len);
+    SPI.slaveReply(reply, len);
+    frame_count++;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    if (!SPI.beginSlave(SS, frames, FRAME_SIZE, onFrame)) {
+        Serial.println("SPI slave mode is not available on these pins");
+    }
+}
+
+void loop()
+{
+    Serial.print("frames: ");
+    Serial.println(frame_count);
+    delay(1000);
+}
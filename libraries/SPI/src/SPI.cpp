@@ -35,6 +35,12 @@ SPIClass::SPIClass(void)
     _spi.pin_sclk = DIGITAL_TO_PINNAME(SCK);
     _spi.pin_ssel = NC;
 
+    _spi.dma = 0;
+    _spi.dma_busy = 0;
+    _async_left = 0;
+    _async_callback = NULL;
+    _slave_callback = NULL;
+
     initialized = false;
 }
 
@@ -45,6 +51,12 @@ SPIClass::SPIClass(PinName mosi, PinName miso, PinName sclk, PinName ssel)
     _spi.pin_sclk = sclk;
     _spi.pin_ssel = ssel;
 
+    _spi.dma = 0;
+    _spi.dma_busy = 0;
+    _async_left = 0;
+    _async_callback = NULL;
+    _slave_callback = NULL;
+
     initialized = false;
 }
 
@@ -55,6 +67,12 @@ SPIClass::SPIClass(PinName mosi, PinName miso, PinName sclk)
     _spi.pin_sclk = sclk;
     _spi.pin_ssel = NC;
 
+    _spi.dma = 0;
+    _spi.dma_busy = 0;
+    _async_left = 0;
+    _async_callback = NULL;
+    _slave_callback = NULL;
+
     initialized = false;
 }
 
@@ -65,7 +83,7 @@ void SPIClass::begin()
         return;
     }
 
-    spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder);
+    spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder, spisettings.databits);
 
     initialized = true;
 }
@@ -80,24 +98,25 @@ void SPIClass::end()
 
 void SPIClass::beginTransaction(SPISettings settings)
 {
+    // back to back transactions with the same settings leave the peripheral alone
+    if (initialized && (settings == spisettings)) {
+        return;
+    }
     config(settings);
-
-    spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder);
-
-    initialized = true;
+    _apply();
 }
 
 void SPIClass::endTransaction(void)
 {
-    if (initialized) {
-        spi_free(&_spi);
-        initialized = false;
-    }
+    // the peripheral stays up until end(), only a running transferAsync() is waited for
+    spi_dma_wait(&_spi);
 }
 
 uint8_t SPIClass::transfer(uint8_t val8)
 {
     uint32_t out_byte;
+    spi_dma_wait(&_spi);
+    spi_frame_bits(&_spi, 8);
     out_byte = spi_master_write(&_spi, val8);
 
     return out_byte;
@@ -105,45 +124,172 @@ uint8_t SPIClass::transfer(uint8_t val8)
 
 uint16_t SPIClass::transfer16(uint16_t val16)
 {
-    uint16_t out_halfword;
-    uint8_t trans_data0, trans_data1, rec_data0, rec_data1;
+    // a 16-bit frame goes out in the same bit order as two bytes, low byte first for LSBFIRST
+    spi_dma_wait(&_spi);
+    spi_frame_bits(&_spi, 16);
+    return spi_master_write(&_spi, val16);
+}
 
-    trans_data0 = uint8_t(val16 & 0x00FF);
-    trans_data1 = uint8_t((val16 & 0xFF00) >> 8);
+void SPIClass::transfer16(uint16_t *buf, size_t count)
+{
+    _block(buf, buf, count, 16);
+}
 
-    if (spisettings.bitorder == LSBFIRST) {
-        rec_data0 = transfer(trans_data0);
-        rec_data1 = transfer(trans_data1);
-        out_halfword = uint16_t(rec_data0 | (rec_data1 << 8));
-    } else {
-        rec_data0 = transfer(trans_data1);
-        rec_data1 = transfer(trans_data0);
-        out_halfword = uint16_t(rec_data1 | (rec_data0 << 8));
+void SPIClass::transfer(void *buf, size_t count)
+{
+    _block(buf, buf, count, 8);
+}
+
+void SPIClass::transfer(void *bufout, void *bufin, size_t count)
+{
+    _block(bufout, bufin, count, 8);
+}
+
+void SPIClass::writeBytes(const void *buf, size_t count)
+{
+    const uint8_t *out = (const uint8_t *)buf;
+    uint16_t chunk;
+
+    spi_dma_wait(&_spi);
+    spi_frame_bits(&_spi, 8);
+    while (count > 0) {
+        chunk = (count > 0xFFFF) ? 0xFFFF : count;
+        if ((chunk < SPI_DMA_THRESHOLD) || !spi_dma_transfer(&_spi, out, NULL, chunk, NULL, NULL)) {
+            spi_master_block_send(&_spi, out, chunk);
+        }
+        out += chunk;
+        count -= chunk;
+    }
+}
+
+void SPIClass::transferAsync(const void *bufout, void *bufin, size_t count, void (*callback)(void))
+{
+    spi_dma_wait(&_spi);
+    spi_frame_bits(&_spi, 8);
+
+    if ((count >= SPI_DMA_THRESHOLD) && spi_dma_start(&_spi)) {
+        _async_out = (const uint8_t *)bufout;
+        _async_in = (uint8_t *)bufin;
+        _async_left = count;
+        _async_callback = callback;
+        _async_next();
+        return;
     }
 
-    return out_halfword;
+    _block(bufout, bufin, count, 8);
+    if (callback != NULL) {
+        callback();
+    }
 }
 
-void SPIClass::transfer(void *buf, size_t count)
+bool SPIClass::transferBusy(void)
 {
-    spi_master_block_write(&_spi, ((uint8_t *)buf), ((uint8_t *)buf), count);
+    return _spi.dma_busy != 0;
 }
 
-void SPIClass::transfer(void *bufout, void *bufin, size_t count)
+void SPIClass::transferWait(void)
 {
-    spi_master_block_write(&_spi, ((uint8_t *)bufout), ((uint8_t *)bufin), count);
+    spi_dma_wait(&_spi);
+}
+
+void SPIClass::_block(const void *out, void *in, size_t count, uint8_t bits)
+{
+    const uint8_t *tx = (const uint8_t *)out;
+    uint8_t *rx = (uint8_t *)in;
+    uint16_t chunk;
+
+    spi_dma_wait(&_spi);
+    spi_frame_bits(&_spi, bits);
+    while (count > 0) {
+        chunk = (count > 0xFFFF) ? 0xFFFF : count;
+        // short blocks are quicker polled than set up for DMA
+        if ((chunk < SPI_DMA_THRESHOLD) || !spi_dma_transfer(&_spi, tx, rx, chunk, NULL, NULL)) {
+            if (bits == 16) {
+                spi_master_block_write16(&_spi, (uint16_t *)tx, (uint16_t *)rx, chunk);
+            } else {
+                spi_master_block_write(&_spi, (uint8_t *)tx, rx, chunk);
+            }
+        }
+        if (tx != NULL) {
+            tx += chunk * (bits / 8);
+        }
+        if (rx != NULL) {
+            rx += chunk * (bits / 8);
+        }
+        count -= chunk;
+    }
+}
+
+void SPIClass::_async_next(void)
+{
+    // a DMA transfer moves at most 0xFFFF bytes, longer ones are chained from the interrupt
+    uint16_t chunk = (_async_left > 0xFFFF) ? 0xFFFF : _async_left;
+    const uint8_t *out = _async_out;
+    uint8_t *in = _async_in;
+
+    if (_async_out != NULL) {
+        _async_out += chunk;
+    }
+    if (_async_in != NULL) {
+        _async_in += chunk;
+    }
+    _async_left -= chunk;
+    spi_dma_transfer(&_spi, out, in, chunk, _dma_done, this);
+}
+
+void SPIClass::_dma_done(void *param)
+{
+    SPIClass *spi = (SPIClass *)param;
+
+    if (spi->_async_left > 0) {
+        spi->_async_next();
+        return;
+    }
+    if (spi->_async_callback != NULL) {
+        spi->_async_callback();
+    }
+}
+
+bool SPIClass::beginSlave(uint32_t nssPin, uint8_t *buffers, size_t frameSize,
+                          void (*onFrame)(const uint8_t *data, size_t len), uint8_t dataMode, BitOrder bitOrder)
+{
+    end();
+    if (frameSize > 0xFFFF) {
+        return false;
+    }
+    _spi.pin_ssel = DIGITAL_TO_PINNAME(nssPin);
+    _slave_callback = onFrame;
+    if (!spi_slave_begin(&_spi, dataMode, bitOrder, buffers, frameSize, _slave_frame, this)) {
+        return false;
+    }
+    initialized = true;
+    return true;
+}
+
+void SPIClass::slaveReply(const uint8_t *data, size_t len)
+{
+    spi_slave_reply(&_spi, data, (len > 0xFFFF) ? 0xFFFF : len);
+}
+
+void SPIClass::_slave_frame(void *param, uint8_t *frame, uint16_t len)
+{
+    SPIClass *spi = (SPIClass *)param;
+
+    if (spi->_slave_callback != NULL) {
+        spi->_slave_callback(frame, len);
+    }
 }
 
 void SPIClass::setBitOrder(BitOrder order)
 {
     spisettings.bitorder = order;
-    spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder);
+    _apply();
 }
 
 void SPIClass::setDataMode(uint8_t mode)
 {
     spisettings.datamode = mode;
-    spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder);
+    _apply();
 }
 
 void SPIClass::setClockDivider(uint32_t divider)
@@ -155,7 +301,7 @@ void SPIClass::setClockDivider(uint32_t divider)
         spisettings.speed = dev_spi_clock_source_frequency_get(&_spi) / divider;
     }
 
-    spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder);
+    _apply();
 }
 
 void SPIClass::config(SPISettings settings)
@@ -163,4 +309,15 @@ void SPIClass::config(SPISettings settings)
     spisettings.speed = settings.speed;
     spisettings.datamode = settings.datamode;
     spisettings.bitorder = settings.bitorder;
+    spisettings.databits = settings.databits;
+}
+
+void SPIClass::_apply(void)
+{
+    if (initialized) {
+        spi_update(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder, spisettings.databits);
+    } else {
+        spi_begin(&_spi, spisettings.speed, spisettings.datamode, spisettings.bitorder, spisettings.databits);
+        initialized = true;
+    }
 }
@@ -46,6 +46,18 @@ class SPISettings
             this->speed = speedMax;
             this->bitorder = bitOrder;
             this->datamode = dataMode;
+            this->databits = 8;
+        }
+
+        /* dataBits (8 or 16) is the frame size the transaction starts with. transfer()
+         * always uses 8-bit and transfer16() 16-bit frames, switching when needed, so
+         * pick the size most of the traffic uses. */
+        SPISettings(uint32_t speedMax, BitOrder bitOrder, uint8_t dataMode, uint8_t dataBits)
+        {
+            this->speed = speedMax;
+            this->bitorder = bitOrder;
+            this->datamode = dataMode;
+            this->databits = (dataBits == 16) ? 16 : 8;
         }
 
         /* Set speed to default, SPI mode set to MODE 0 and Bit order set to MSB first. */
@@ -54,11 +66,19 @@ class SPISettings
             this->speed = SPI_SPEED_DEFAULT;
             this->bitorder = MSBFIRST;
             this->datamode = SPI_MODE0;
+            this->databits = 8;
+        }
+
+        bool operator==(const SPISettings &rhs) const
+        {
+            return (speed == rhs.speed) && (datamode == rhs.datamode) &&
+                   (bitorder == rhs.bitorder) && (databits == rhs.databits);
         }
 
     private:
         uint32_t speed;
         uint8_t datamode;
+        uint8_t databits;
         BitOrder bitorder;
 
         friend class SPIClass;
@@ -81,8 +101,30 @@ class SPIClass
 
         uint8_t transfer(uint8_t val8);
         uint16_t transfer16(uint16_t val16);
+        // 16-bit frames in place, through DMA for long buffers
+        void transfer16(uint16_t *buf, size_t count);
         void transfer(void *buf, size_t count);
         void transfer(void *bufout, void *bufin, size_t count);
+        // Send only, what comes back on MISO is dropped
+        void writeBytes(const void *buf, size_t count);
+        // Start a DMA transfer and return at once, callback runs from the DMA
+        // interrupt when the last byte is in. The buffers must stay valid until
+        // then. A NULL bufout sends 0xFF, a NULL bufin discards what is received.
+        // Short transfers, or ones without a free DMA channel, are done before
+        // returning and call callback from here.
+        void transferAsync(const void *bufout, void *bufin, size_t count, void (*callback)(void) = NULL);
+        bool transferBusy(void);
+        void transferWait(void);
+
+        // Run as a slave. Frames are delimited by nssPin, which must be the hardware
+        // NSS pin of the SPI, and received by DMA into the two halves of buffers
+        // (2 * frameSize bytes). onFrame is called from an interrupt when NSS rises,
+        // while the next frame already goes into the other half. end() stops it.
+        bool beginSlave(uint32_t nssPin, uint8_t *buffers, size_t frameSize,
+                        void (*onFrame)(const uint8_t *data, size_t len),
+                        uint8_t dataMode = SPI_MODE0, BitOrder bitOrder = MSBFIRST);
+        // Bytes sent to the master in the next frame, they must stay valid until it ends
+        void slaveReply(const uint8_t *data, size_t len);
 
         void setBitOrder(BitOrder order);
         void setDataMode(uint8_t mode);
@@ -90,10 +132,21 @@ class SPIClass
 
     private:
         void config(SPISettings settings);
+        void _apply(void);
+        void _block(const void *out, void *in, size_t count, uint8_t bits);
+        void _async_next(void);
+        static void _dma_done(void *param);
+        static void _slave_frame(void *param, uint8_t *frame, uint16_t len);
 
         SPISettings spisettings;
         bool initialized;
         spi_t         _spi;
+        // remainder of a transferAsync() beyond one DMA transfer
+        const uint8_t *_async_out;
+        uint8_t *_async_in;
+        size_t _async_left;
+        void (*_async_callback)(void);
+        void (*_slave_callback)(const uint8_t *data, size_t len);
 
 };
 
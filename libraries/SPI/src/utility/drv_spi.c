@@ -28,6 +28,7 @@ OF SUCH DAMAGE.
 */
 
 #include "drv_spi.h"
+#include "gpio_interrupt.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +36,45 @@ extern "C" {
 
 #define SPI_S(obj)    (( struct spi_s *)(obj))
 #define SPI_PINS_FREE_MODE   0x00000001
+#define SPI_DMA_NUM          3
+/* clocked out when a transfer has no tx buffer */
+#define SPI_FILL_WORD        0xFFFF
+
+static void spi_slave_end(spi_t *obj);
+
+/* DMA request lines of the SPI receivers, periph 0 where there is none */
+static const dma_chan_t spi_rx_dma[SPI_DMA_NUM] = {
+#if DMA_HAS_PERIPH_ARG
+    {DMA0, DMA_CH1},
+    {DMA0, DMA_CH3},
+#if defined(DMA_HAS_DMA1)
+    {DMA1, DMA_CH0},
+#else
+    {0U, DMA_CH0},
+#endif
+#else
+    {DMA, DMA_CH1},
+    {DMA, DMA_CH3},
+    {0U, DMA_CH0},
+#endif
+};
+
+/* DMA request lines of the SPI transmitters */
+static const dma_chan_t spi_tx_dma[SPI_DMA_NUM] = {
+#if DMA_HAS_PERIPH_ARG
+    {DMA0, DMA_CH2},
+    {DMA0, DMA_CH4},
+#if defined(DMA_HAS_DMA1)
+    {DMA1, DMA_CH1},
+#else
+    {0U, DMA_CH1},
+#endif
+#else
+    {DMA, DMA_CH2},
+    {DMA, DMA_CH4},
+    {0U, DMA_CH1},
+#endif
+};
 
 /** Initialize the SPI structure
  *
@@ -83,21 +123,97 @@ uint32_t dev_spi_clock_source_frequency_get(spi_t *obj)
     return spi_freq;
 }
 
-/**
-  * @brief  SPI initialization function
-  * @param  obj : pointer to spi_t structure
-  * @param  speed : spi output speed
-  * @param  mode : one of the spi modes
-  * @param  msb : set to 1 in msb first
-  * @retval None
-  */
-void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian)
+/** Work out the clock, mode, bit order and frame size fields of the SPI parameters
+ *
+ * @param obj        The SPI object
+ * @param speed      SPI output speed
+ * @param mode       One of SPI_MODE0..3
+ * @param endian     0 for LSB first
+ * @param frame_bits 8 or 16
+ * @return 0 if the mode is not valid, 1 otherwise
+ */
+static uint8_t dev_spi_format(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian, uint8_t frame_bits)
 {
     struct spi_s *spiobj = SPI_S(obj);
-
     uint32_t spi_freq = 0;
 
-    /* Determine the SPI to use */
+    spi_freq = dev_spi_clock_source_frequency_get(obj);
+    if (speed >= (spi_freq / SPI_CLOCK_DIV2)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_2;
+    } else if (speed >= (spi_freq / SPI_CLOCK_DIV4)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_4;
+    } else if (speed >= (spi_freq / SPI_CLOCK_DIV8)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_8;
+    } else if (speed >= (spi_freq / SPI_CLOCK_DIV16)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_16;
+    } else if (speed >= (spi_freq / SPI_CLOCK_DIV32)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_32;
+    } else if (speed >= (spi_freq / SPI_CLOCK_DIV64)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_64;
+    } else if (speed >= (spi_freq / SPI_CLOCK_DIV128)) {
+        spiobj->spi_struct.prescale             = SPI_PSC_128;
+    } else {
+        /*
+         * As it is not possible to go below (spi_freq / SPI_SPEED_CLOCK_DIV256_MHZ).
+         * Set prescaler at max value so get the lowest frequency possible.
+         */
+        spiobj->spi_struct.prescale             = SPI_PSC_256;
+    }
+
+    if (mode == SPI_MODE0) {
+        spiobj->spi_struct.clock_polarity_phase = SPI_CK_PL_LOW_PH_1EDGE;
+    } else if (mode == SPI_MODE1) {
+        spiobj->spi_struct.clock_polarity_phase = SPI_CK_PL_LOW_PH_2EDGE;
+    } else if (mode == SPI_MODE2) {
+        spiobj->spi_struct.clock_polarity_phase =  SPI_CK_PL_HIGH_PH_1EDGE;
+    } else if (mode == SPI_MODE3) {
+        spiobj->spi_struct.clock_polarity_phase = SPI_CK_PL_HIGH_PH_2EDGE;
+    } else {
+        return 0;
+    }
+
+    if (endian == 0) {
+        spiobj->spi_struct.endian               = SPI_ENDIAN_LSB;
+    } else {
+        spiobj->spi_struct.endian               = SPI_ENDIAN_MSB;
+    }
+
+    spiobj->spi_struct.frame_size           = (frame_bits == 16U) ? SPI_FRAMESIZE_16BIT : SPI_FRAMESIZE_8BIT;
+
+    return 1;
+}
+
+/** Configure a pin as an SPI slave input
+ *
+ * The F10x/F30x/E50x pin maps select AF push-pull, which would drive the
+ * clock and data inputs of a slave, so only the remap is taken from the map.
+ * @param pin The pin
+ * @param map The pin map of its function
+ */
+static void dev_spi_slave_pinout(PinName pin, const PinMap *map)
+{
+#if defined(GD32F30x) || defined(GD32F10x) || defined(GD32E50X)
+    int function;
+
+    if (pin == NC) {
+        return;
+    }
+    function = (int)pinmap_function(pin, map);
+    function &= ~(PIN_MODE_MASK << PIN_MODE_SHIFT);
+    function |= PIN_MODE_IN_FLOATING << PIN_MODE_SHIFT;
+    pin_function(pin, function);
+#else
+    pinmap_pinout(pin, map);
+#endif
+}
+
+/** Find the SPI the pins of the object belong to, without touching the hardware
+ *
+ * @param spiobj The SPI object
+ * @return The SPI, or NC when the pins do not share one
+ */
+static SPIName dev_spi_name(struct spi_s *spiobj)
+{
     SPIName spi_mosi = (SPIName)pinmap_peripheral(spiobj->pin_mosi, PinMap_SPI_MOSI);
     SPIName spi_miso = (SPIName)pinmap_peripheral(spiobj->pin_miso, PinMap_SPI_MISO);
     SPIName spi_sclk = (SPIName)pinmap_peripheral(spiobj->pin_sclk, PinMap_SPI_SCLK);
@@ -107,7 +223,20 @@ void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian)
     SPIName spi_data = (SPIName)pinmap_merge(spi_mosi, spi_miso);
     SPIName spi_cntl = (SPIName)pinmap_merge(spi_sclk, spi_ssel);
 
-    spiobj->spi = (SPIName)pinmap_merge(spi_data, spi_cntl);
+    return (SPIName)pinmap_merge(spi_data, spi_cntl);
+}
+
+/** Find the SPI of the pins, enable its clock and route the pins
+ *
+ * @param obj   The SPI object
+ * @param slave Non-zero to set the pins up for slave mode
+ */
+static void dev_spi_pinout(spi_t *obj, uint8_t slave)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+
+    /* Determine the SPI to use */
+    spiobj->spi = dev_spi_name(spiobj);
 
     /* enable SPI clock */
     if (spiobj->spi == SPI0) {
@@ -122,6 +251,16 @@ void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian)
     }
 #endif
 
+    if (slave) {
+        /* MISO is the only output of a slave, NSS is required */
+        dev_spi_slave_pinout(spiobj->pin_mosi, PinMap_SPI_MOSI);
+        pinmap_pinout(spiobj->pin_miso, PinMap_SPI_MISO);
+        dev_spi_slave_pinout(spiobj->pin_sclk, PinMap_SPI_SCLK);
+        dev_spi_slave_pinout(spiobj->pin_ssel, PinMap_SPI_SSEL);
+        spiobj->spi_struct.nss = SPI_NSS_HARD;
+        return;
+    }
+
     /* configure GPIO mode of SPI pins */
     pinmap_pinout(spiobj->pin_mosi, PinMap_SPI_MOSI);
     pinmap_pinout(spiobj->pin_miso, PinMap_SPI_MISO);
@@ -135,56 +274,69 @@ void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian)
     } else {
         spiobj->spi_struct.nss = SPI_NSS_SOFT;
     }
+}
 
-    spi_freq = dev_spi_clock_source_frequency_get(obj);
-    if (speed >= (spi_freq / SPI_CLOCK_DIV2)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_2;
-    } else if (speed >= (spi_freq / SPI_CLOCK_DIV4)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_4;
-    } else if (speed >= (spi_freq / SPI_CLOCK_DIV8)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_8;
-    } else if (speed >= (spi_freq / SPI_CLOCK_DIV16)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_16;
-    } else if (speed >= (spi_freq / SPI_CLOCK_DIV32)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_32;
-    } else if (speed >= (spi_freq / SPI_CLOCK_DIV64)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_64;
-    } else if (speed >= (spi_freq / SPI_CLOCK_DIV128)) {
-        spiobj->spi_struct.prescale             = SPI_PSC_128;
-    } else {
-        /*
-         * As it is not possible to go below (spi_freq / SPI_SPEED_CLOCK_DIV256_MHZ).
-         * Set prescaler at max value so get the lowest frequency possible.
-         */
-        spiobj->spi_struct.prescale             = SPI_PSC_256;
-    }
+/**
+  * @brief  SPI initialization function
+  * @param  obj : pointer to spi_t structure
+  * @param  speed : spi output speed
+  * @param  mode : one of the spi modes
+  * @param  msb : set to 1 in msb first
+  * @param  frame_bits : frame size, 8 or 16
+  * @retval None
+  */
+void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian, uint8_t frame_bits)
+{
+    struct spi_s *spiobj = SPI_S(obj);
 
-    if (mode == SPI_MODE0) {
-        spiobj->spi_struct.clock_polarity_phase = SPI_CK_PL_LOW_PH_1EDGE;
-    } else if (mode == SPI_MODE1) {
-        spiobj->spi_struct.clock_polarity_phase = SPI_CK_PL_LOW_PH_2EDGE;
-    } else if (mode == SPI_MODE2) {
-        spiobj->spi_struct.clock_polarity_phase =  SPI_CK_PL_HIGH_PH_1EDGE;
-    } else if (mode == SPI_MODE3) {
-        spiobj->spi_struct.clock_polarity_phase = SPI_CK_PL_HIGH_PH_2EDGE;
-    } else {
-        return;
-    }
+    /* do not reconfigure under a running DMA transfer */
+    spi_dma_wait(obj);
 
-    if (endian == 0) {
-        spiobj->spi_struct.endian               = SPI_ENDIAN_LSB;
-    } else {
-        spiobj->spi_struct.endian               = SPI_ENDIAN_MSB;
+    dev_spi_pinout(obj, 0U);
+
+    if (!dev_spi_format(obj, speed, mode, endian, frame_bits)) {
+        return;
     }
 
     /* Default values */
     spiobj->spi_struct.trans_mode           = SPI_TRANSMODE_FULLDUPLEX;
     spiobj->spi_struct.device_mode          = SPI_MASTER;
-    spiobj->spi_struct.frame_size           = SPI_FRAMESIZE_8BIT;
 
     dev_spi_struct_init(obj);
 }
 
+/**
+  * @brief  Change the settings of an SPI set up by spi_begin
+  * @note   Only the control register is rewritten, and only when a field
+  *         differs: clocks, pins and DMA channels stay as they are.
+  * @param  obj : pointer to spi_t structure
+  * @param  speed : spi output speed
+  * @param  mode : one of the spi modes
+  * @param  msb : set to 1 in msb first
+  * @param  frame_bits : frame size, 8 or 16
+  * @retval None
+  */
+void spi_update(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian, uint8_t frame_bits)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    spi_parameter_struct active = spiobj->spi_struct;
+
+    if (!dev_spi_format(obj, speed, mode, endian, frame_bits)) {
+        spiobj->spi_struct = active;
+        return;
+    }
+    if ((active.prescale == spiobj->spi_struct.prescale) &&
+            (active.clock_polarity_phase == spiobj->spi_struct.clock_polarity_phase) &&
+            (active.endian == spiobj->spi_struct.endian) &&
+            (active.frame_size == spiobj->spi_struct.frame_size)) {
+        return;
+    }
+
+    /* do not reconfigure under a running DMA transfer */
+    spi_dma_wait(obj);
+    dev_spi_struct_init(obj);
+}
+
 /**
   * @brief This function is implemented to deinitialize the SPI interface
   *        (IOs + SPI block)
@@ -194,6 +346,9 @@ void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian)
 void spi_free(spi_t *obj)
 {
     struct spi_s *spiobj = SPI_S(obj);
+
+    spi_slave_end(obj);
+    spi_dma_stop(obj);
     spi_disable(spiobj->spi);
 
     /* Disable and deinit SPI */
@@ -224,10 +379,10 @@ void spi_free(spi_t *obj)
 /**
   * @brief This function is implemented by user to send data over SPI interface
   * @param  obj : pointer to spi_t structure
-  * @param  value : data to be sent
+  * @param  value : data to be sent, a byte or a 16-bit frame
   * @retval status of the send operation (0) in case of error
   */
-uint32_t spi_master_write(spi_t *obj, uint8_t value)
+uint32_t spi_master_write(spi_t *obj, uint16_t value)
 {
     int count = 0;
     struct spi_s *spiobj = SPI_S(obj);
@@ -250,21 +405,591 @@ uint32_t spi_master_write(spi_t *obj, uint8_t value)
     }
 }
 
+/** Fetch the next frame to send of a block transfer
+ *
+ * @param tx_buffer Frames to send, NULL for SPI_FILL_WORD
+ * @param index     Frame index
+ * @param wide      Non-zero if the buffer holds 16-bit frames
+ * @return The frame
+ */
+static inline uint16_t spi_block_frame(const void *tx_buffer, uint16_t index, uint8_t wide)
+{
+    if (tx_buffer == NULL) {
+        return SPI_FILL_WORD;
+    }
+    return wide ? ((const uint16_t *)tx_buffer)[index] : ((const uint8_t *)tx_buffer)[index];
+}
+
+/** Pipelined polled block transfer of 8 or 16-bit frames
+ *
+ * The next frame is loaded as soon as the transmit buffer is free, so SCK
+ * runs back to back. When frames are kept, each load of the next frame and
+ * the read of the current one run with interrupts masked: an interrupt can
+ * only come while a single frame is in flight, so it stalls SCK instead of
+ * overrunning the receive buffer. Interrupts are held off for at most about
+ * one frame time.
+ * @param obj       The SPI object
+ * @param tx_buffer Frames to send, NULL to send SPI_FILL_WORD
+ * @param rx_buffer Received frames, NULL to discard them
+ * @param len       Number of frames, nothing is clocked for 0
+ * @param wide      Non-zero if the buffers hold 16-bit frames
+ * @return 0 on success, -1 if the SPI is disabled
+ */
+static int spi_block_transfer(spi_t *obj, const void *tx_buffer, void *rx_buffer, uint16_t len, uint8_t wide)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint32_t spi = spiobj->spi;
+    uint16_t tx_count = 0, rx_count = 0;
+    uint32_t stat, primask;
+    uint16_t in;
+
+    if (len == 0U) {
+        return 0;
+    }
+    if (!(SPI_CTL0(spi) & SPI_CTL0_SPIEN)) {
+        return -1;
+    }
+
+    /* a frame left over would be taken as the first one received */
+    while (SPI_STAT(spi) & SPI_STAT_RBNE) {
+        (void)SPI_DATA(spi);
+    }
+
+    if (rx_buffer == NULL) {
+        /* nothing to lose: keep one frame in the shift register and the next
+         * one waiting, an overrun only drops a frame nobody reads */
+        while (rx_count < len) {
+            stat = SPI_STAT(spi);
+            if ((stat & SPI_STAT_TBE) && (tx_count < len) && ((uint16_t)(tx_count - rx_count) < 2U)) {
+                SPI_DATA(spi) = spi_block_frame(tx_buffer, tx_count, wide);
+                tx_count++;
+            }
+            if (stat & SPI_STAT_RBNE) {
+                (void)SPI_DATA(spi);
+                rx_count++;
+                if (stat & SPI_STAT_RXORERR) {
+                    /* the frame after this one was dropped, reading STAT after DATA clears the error */
+                    (void)SPI_STAT(spi);
+                    rx_count++;
+                }
+            }
+        }
+        return 0;
+    }
+
+    SPI_DATA(spi) = spi_block_frame(tx_buffer, 0U, wide);
+    tx_count = 1U;
+    primask = __get_PRIMASK();
+    while (rx_count < len) {
+        __disable_irq();
+        if (tx_count < len) {
+            while (!(SPI_STAT(spi) & SPI_STAT_TBE));
+            SPI_DATA(spi) = spi_block_frame(tx_buffer, tx_count, wide);
+            tx_count++;
+        }
+        while (!(SPI_STAT(spi) & SPI_STAT_RBNE));
+        in = (uint16_t)SPI_DATA(spi);
+        __set_PRIMASK(primask);
+        if (wide) {
+            ((uint16_t *)rx_buffer)[rx_count] = in;
+        } else {
+            ((uint8_t *)rx_buffer)[rx_count] = (uint8_t)in;
+        }
+        rx_count++;
+    }
+    return 0;
+}
+
+/** Send frames and ignore what comes back
+ *
+ * @param obj       The SPI object
+ * @param tx_buffer Frames to send
+ * @param len       Number of frames
+ * @param wide      Non-zero if the buffer holds 16-bit frames
+ */
+static void spi_block_send(spi_t *obj, const void *tx_buffer, uint16_t len, uint8_t wide)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint32_t spi = spiobj->spi;
+    uint16_t i;
+
+    if (!(SPI_CTL0(spi) & SPI_CTL0_SPIEN)) {
+        return;
+    }
+
+    for (i = 0; i < len; i++) {
+        while (!(SPI_STAT(spi) & SPI_STAT_TBE));
+        SPI_DATA(spi) = wide ? ((const uint16_t *)tx_buffer)[i] : ((const uint8_t *)tx_buffer)[i];
+    }
+    while (!(SPI_STAT(spi) & SPI_STAT_TBE));
+    while (SPI_STAT(spi) & SPI_STAT_TRANS);
+
+    /* drop the last frame received and the overrun the others caused */
+    (void)SPI_DATA(spi);
+    (void)SPI_STAT(spi);
+}
+
 /**
   * @brief This function is implemented by user to send/receive data over
   *         SPI interface
+  * @note   SCK runs back to back; interrupts are masked for about a byte
+  *         at a time while bytes are received, so none can be lost.
   * @param  obj : pointer to spi_t structure
-  * @param  tx_buffer : tx data to send before reception
-  * @param  rx_buffer : data to receive
+  * @param  tx_buffer : tx data to send before reception, NULL to send 0xFF
+  * @param  rx_buffer : data to receive, NULL to discard it
   * @param  len : length in byte of the data to send and receive
-  * @retval status of the send operation (0) in case of error
+  * @retval 0 on success, -1 if the SPI is disabled
+  */
+int spi_master_block_write(spi_t *obj, uint8_t *tx_buffer, uint8_t *rx_buffer, uint16_t len)
+{
+    return spi_block_transfer(obj, tx_buffer, rx_buffer, len, 0U);
+}
+
+/**
+  * @brief Send/receive 16-bit frames, the SPI must be set to 16-bit frames
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : frames to send, NULL to send 0xFFFF
+  * @param  rx_buffer : frames received, NULL to discard them
+  * @param  len : number of frames
+  * @retval 0 on success, -1 if the SPI is disabled
+  */
+int spi_master_block_write16(spi_t *obj, uint16_t *tx_buffer, uint16_t *rx_buffer, uint16_t len)
+{
+    return spi_block_transfer(obj, tx_buffer, rx_buffer, len, 1U);
+}
+
+/**
+  * @brief Send a block over SPI and ignore what comes back
+  * @note   Meant for displays, LED strips and the like, the transmit buffer
+  *         is refilled as soon as it empties. Returns once the last bit is out.
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : data to send
+  * @param  len : length in byte of the data to send
+  * @retval None
+  */
+void spi_master_block_send(spi_t *obj, const uint8_t *tx_buffer, uint16_t len)
+{
+    spi_block_send(obj, tx_buffer, len, 0U);
+}
+
+/**
+  * @brief Send 16-bit frames and ignore what comes back, the SPI must be set to 16-bit frames
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : frames to send
+  * @param  len : number of frames
+  * @retval None
+  */
+void spi_master_block_send16(spi_t *obj, const uint16_t *tx_buffer, uint16_t len)
+{
+    spi_block_send(obj, tx_buffer, len, 1U);
+}
+
+/**
+  * @brief Switch between 8 and 16-bit frames
+  * @note   The SPI is briefly disabled when the size changes, nothing happens otherwise
+  * @param  obj : pointer to spi_t structure
+  * @param  frame_bits : 8 or 16
+  * @retval None
   */
-void spi_master_block_write(spi_t *obj, uint8_t *tx_buffer, uint8_t *rx_buffer, uint16_t len)
+void spi_frame_bits(spi_t *obj, uint8_t frame_bits)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint32_t frame_size = (frame_bits == 16U) ? SPI_FRAMESIZE_16BIT : SPI_FRAMESIZE_8BIT;
+
+    if (spiobj->spi_struct.frame_size == frame_size) {
+        return;
+    }
+    spi_dma_wait(obj);
+    spiobj->spi_struct.frame_size = frame_size;
+    dev_spi_struct_init(obj);
+}
+
+/** Get the slot of an SPI in the DMA channel tables
+ *
+ * @param spi The SPI peripheral
+ * @return The slot, or SPI_DMA_NUM if the SPI has no DMA request lines
+ */
+static uint8_t spi_dma_slot(SPIName spi)
 {
-    for (int i = 0; i < len; i++) {
-        char in = spi_master_write(obj, tx_buffer[i]);
-        rx_buffer[i] = in;
+    switch ((int)spi) {
+        case SPI0:
+            return 0;
+        case SPI1:
+            return 1;
+#ifdef SPI2
+        case SPI2:
+            return 2;
+#endif
+        default:
+            return SPI_DMA_NUM;
+    }
+}
+
+/** End the current DMA transfer and run its callback
+ *
+ * Called from the DMA interrupt and from spi_dma_wait(), whichever sees the end first.
+ * @param obj The SPI object
+ */
+static void spi_dma_finish(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint32_t primask = __get_PRIMASK();
+    spi_dma_callback_t callback;
+
+    __disable_irq();
+    if (!spiobj->dma_busy) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    spi_dma_disable(spiobj->spi, SPI_DMA_TRANSMIT);
+    spi_dma_disable(spiobj->spi, SPI_DMA_RECEIVE);
+    dma_chan_stop(&spi_tx_dma[spiobj->dma_index]);
+    dma_chan_stop(&spi_rx_dma[spiobj->dma_index]);
+    callback = spiobj->dma_callback;
+    spiobj->dma_busy = 0U;
+    __set_PRIMASK(primask);
+
+    if (callback != NULL) {
+        callback(spiobj->dma_param);
+    }
+}
+
+/** DMA interrupt of both channels: RX complete, or an error on either side
+ *
+ * @param param The SPI object
+ * @param flags The channel flags
+ */
+static void spi_dma_irq(void *param, uint32_t flags)
+{
+    (void)flags;
+    spi_dma_finish((spi_t *)param);
+}
+
+/** Set the item size of both DMA channels, if it changed
+ *
+ * @param obj   The SPI object, with its channels claimed
+ * @param width 8 or 16
+ */
+static void spi_dma_width(spi_t *obj, uint8_t width)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+
+    if (spiobj->dma_width == width) {
+        return;
+    }
+    /* RX ranks above TX so a received frame is always fetched before the next one lands */
+    dma_chan_setup(&spi_rx_dma[spiobj->dma_index], (uint32_t)&SPI_DATA(spiobj->spi), DMA_PERIPHERAL_TO_MEMORY,
+                   width, 0U, DMA_PRIORITY_HIGH);
+    dma_chan_setup(&spi_tx_dma[spiobj->dma_index], (uint32_t)&SPI_DATA(spiobj->spi), DMA_MEMORY_TO_PERIPHERAL,
+                   width, 0U, DMA_PRIORITY_MEDIUM);
+    spiobj->dma_width = width;
+}
+
+/** Claim the DMA channels of the SPI
+ *
+ * @param obj The SPI object
+ * @return 1 if block transfers can use spi_dma_transfer(), 0 otherwise
+ */
+uint8_t spi_dma_start(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint8_t index = spi_dma_slot(spiobj->spi);
+
+    if (spiobj->dma) {
+        return 1;
+    }
+    if (index >= SPI_DMA_NUM) {
+        return 0;
+    }
+    if (!dma_chan_attach(&spi_rx_dma[index], spi_dma_irq, obj)) {
+        return 0;
+    }
+    if (!dma_chan_attach(&spi_tx_dma[index], spi_dma_irq, obj)) {
+        dma_chan_detach(&spi_rx_dma[index]);
+        return 0;
+    }
+
+    spiobj->dma_index = index;
+    spiobj->dma_width = 0U;
+    spiobj->dma_busy = 0U;
+    spiobj->dma_fill = SPI_FILL_WORD;
+    spiobj->dma = 1U;
+
+    return 1;
+}
+
+/** Release the DMA channels of the SPI, after the running transfer ends
+ *
+ * @param obj The SPI object
+ */
+void spi_dma_stop(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+
+    if (!spiobj->dma) {
+        return;
+    }
+
+    spi_dma_wait(obj);
+    dma_chan_detach(&spi_tx_dma[spiobj->dma_index]);
+    dma_chan_detach(&spi_rx_dma[spiobj->dma_index]);
+    spiobj->dma = 0U;
+}
+
+/** Send and receive a block through DMA
+ *
+ * Without a callback the call returns once the last byte is received. With a
+ * callback it returns at once, and callback runs from the DMA interrupt (or
+ * from spi_dma_wait()) when the transfer is over; the buffers must stay valid
+ * until then.
+ * @param obj       The SPI object
+ * @param tx_buffer Frames to send, NULL to send SPI_FILL_WORD
+ * @param rx_buffer Received frames, NULL to discard them
+ * @param len       Number of frames, the buffers hold uint16_t with 16-bit frames
+ * @param callback  Completion callback, NULL to wait for the transfer
+ * @param param     Passed back to the callback
+ * @return 1 if the transfer was done or started, 0 if the caller must fall back to spi_master_block_write()
+ */
+uint8_t spi_dma_transfer(spi_t *obj, const void *tx_buffer, void *rx_buffer, uint16_t len,
+                         spi_dma_callback_t callback, void *param)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    const dma_chan_t *rx, *tx;
+    uint32_t int_sources;
+    uint8_t width = (spiobj->spi_struct.frame_size == SPI_FRAMESIZE_16BIT) ? 16U : 8U;
+
+    if ((len == 0U) || !spi_dma_start(obj)) {
+        return 0;
+    }
+    spi_dma_wait(obj);
+
+    rx = &spi_rx_dma[spiobj->dma_index];
+    tx = &spi_tx_dma[spiobj->dma_index];
+
+    spi_dma_width(obj, width);
+
+    /* a frame left from a polled transfer would be taken as the first one received */
+    while (RESET != spi_i2s_flag_get(spiobj->spi, SPI_FLAG_RBNE)) {
+        (void)spi_i2s_data_receive(spiobj->spi);
+    }
+
+    dma_chan_memory_increase(rx, rx_buffer != NULL);
+    dma_chan_memory_increase(tx, tx_buffer != NULL);
+
+    spiobj->dma_callback = callback;
+    spiobj->dma_param = param;
+    spiobj->dma_busy = 1U;
+
+    /* a blocking transfer is polled, so it also works with interrupts off */
+    int_sources = (callback != NULL) ? DMA_INT_ERR : 0U;
+    dma_chan_start(rx, (rx_buffer != NULL) ? rx_buffer : &spiobj->dma_sink, len,
+                   (int_sources != 0U) ? (int_sources | DMA_INT_FTF) : 0U);
+    dma_chan_start(tx, (tx_buffer != NULL) ? tx_buffer : &spiobj->dma_fill, len, int_sources);
+    spi_dma_enable(spiobj->spi, SPI_DMA_RECEIVE);
+    spi_dma_enable(spiobj->spi, SPI_DMA_TRANSMIT);
+
+    if (callback == NULL) {
+        spi_dma_wait(obj);
+    }
+    return 1;
+}
+
+/** Wait for the running DMA transfer, if any
+ *
+ * @param obj The SPI object
+ */
+void spi_dma_wait(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+
+    while (spiobj->dma_busy) {
+        if (dma_chan_remaining(&spi_rx_dma[spiobj->dma_index]) == 0U) {
+            spi_dma_finish(obj);
+        }
+    }
+}
+
+/* slave objects by DMA slot, for the NSS interrupts which carry no argument */
+static spi_t *spi_slave_obj[SPI_DMA_NUM];
+
+/** Start receiving the next slave frame into the free half of the buffer
+ *
+ * @param obj The SPI object
+ */
+static void spi_slave_arm_rx(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+
+    dma_chan_start(&spi_rx_dma[spiobj->dma_index], spiobj->slave_buffer + spiobj->slave_half * spiobj->slave_size,
+                   spiobj->slave_size, 0U);
+    spi_dma_enable(spiobj->spi, SPI_DMA_RECEIVE);
+}
+
+/** Load the reply for the next slave frame, SPI_FILL_WORD bytes if there is none
+ *
+ * @param obj The SPI object
+ */
+static void spi_slave_arm_tx(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    const dma_chan_t *tx = &spi_tx_dma[spiobj->dma_index];
+    const uint8_t *reply = spiobj->slave_reply;
+
+    spiobj->slave_reply = NULL;
+    dma_chan_memory_increase(tx, reply != NULL);
+    if (reply != NULL) {
+        dma_chan_start(tx, reply, spiobj->slave_reply_len, 0U);
+    } else {
+        dma_chan_start(tx, &spiobj->dma_fill, spiobj->slave_size, 0U);
+    }
+    spi_dma_enable(spiobj->spi, SPI_DMA_TRANSMIT);
+}
+
+/** NSS went high: hand the frame over and rearm for the next one
+ *
+ * @param obj The SPI object
+ */
+static void spi_slave_frame_end(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint8_t *frame = spiobj->slave_buffer + spiobj->slave_half * spiobj->slave_size;
+    uint16_t len = spiobj->slave_size - dma_chan_remaining(&spi_rx_dma[spiobj->dma_index]);
+
+    spi_dma_disable(spiobj->spi, SPI_DMA_TRANSMIT);
+    spi_dma_disable(spiobj->spi, SPI_DMA_RECEIVE);
+    dma_chan_stop(&spi_tx_dma[spiobj->dma_index]);
+    dma_chan_stop(&spi_rx_dma[spiobj->dma_index]);
+
+    /* the transmit buffer still holds a byte fetched for this frame, only a reset drops it */
+    spi_i2s_deinit(spiobj->spi);
+    dev_spi_struct_init(obj);
+
+    spiobj->slave_half ^= 1U;
+    spi_slave_arm_rx(obj);
+    if ((len > 0U) && (spiobj->slave_callback != NULL)) {
+        spiobj->slave_callback(spiobj->slave_param, frame, len);
+    }
+    spi_slave_arm_tx(obj);
+}
+
+static void spi_slave_nss_irq0(void)
+{
+    spi_slave_frame_end(spi_slave_obj[0]);
+}
+
+static void spi_slave_nss_irq1(void)
+{
+    spi_slave_frame_end(spi_slave_obj[1]);
+}
+
+static void spi_slave_nss_irq2(void)
+{
+    spi_slave_frame_end(spi_slave_obj[2]);
+}
+
+static void (*const spi_slave_nss_irqs[SPI_DMA_NUM])(void) = {
+    spi_slave_nss_irq0, spi_slave_nss_irq1, spi_slave_nss_irq2
+};
+
+/** Start the SPI as a slave receiving NSS delimited frames through DMA
+ *
+ * Frames land alternately in the two halves of buffers. When NSS rises the
+ * frame is passed to callback, from the EXTI interrupt, while the next one
+ * is already being received into the other half; the callback must be done
+ * with the data before that frame ends. The peripheral is reset at every
+ * frame end to drop the byte preloaded for transmission, so the master must
+ * leave a few microseconds between frames.
+ * @param obj        The SPI object, pin_ssel must be the hardware NSS pin
+ * @param mode       One of SPI_MODE0..3
+ * @param endian     0 for LSB first
+ * @param buffers    Room for two frames, 2 * frame_size bytes
+ * @param frame_size Longest frame, longer ones are cut
+ * @param callback   Called with each received frame
+ * @param param      Passed back to the callback
+ * @return 1 on success, 0 without NSS pin or free DMA channels
+ */
+uint8_t spi_slave_begin(spi_t *obj, uint8_t mode, uint8_t endian, uint8_t *buffers, uint16_t frame_size,
+                        spi_slave_callback_t callback, void *param)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint8_t index;
+
+    if ((spiobj->pin_ssel == NC) || (buffers == NULL) || (frame_size == 0U)) {
+        return 0;
+    }
+
+    spi_dma_wait(obj);
+    /* every check comes before the pins and the SPI are touched, so a
+       refused call leaves them as they were */
+    spiobj->spi = dev_spi_name(spiobj);
+    index = spi_dma_slot(spiobj->spi);
+    if ((index >= SPI_DMA_NUM) || (spi_slave_obj[index] != NULL)) {
+        return 0;
+    }
+    if (!dev_spi_format(obj, 0U, mode, endian, 8U)) {
+        return 0;
+    }
+    if (!spi_dma_start(obj)) {
+        return 0;
+    }
+
+    dev_spi_pinout(obj, 1U);
+    spiobj->spi_struct.trans_mode           = SPI_TRANSMODE_FULLDUPLEX;
+    spiobj->spi_struct.device_mode          = SPI_SLAVE;
+    dev_spi_struct_init(obj);
+    spi_dma_width(obj, 8U);
+
+    spiobj->slave_buffer = buffers;
+    spiobj->slave_size = frame_size;
+    spiobj->slave_half = 0U;
+    spiobj->slave_reply = NULL;
+    spiobj->slave_callback = callback;
+    spiobj->slave_param = param;
+    spi_slave_obj[index] = obj;
+
+    spi_slave_arm_rx(obj);
+    spi_slave_arm_tx(obj);
+    gpio_interrupt_enable(GD_PORT_GET(spiobj->pin_ssel), GD_PIN_GET(spiobj->pin_ssel), spi_slave_nss_irqs[index],
+                          EXTI_TRIG_RISING);
+
+    return 1;
+}
+
+/** Queue the bytes a slave sends during the next frame
+ *
+ * Called from the frame callback the reply goes out in the frame after the
+ * one that just ended. Past len the last byte repeats.
+ * @param obj  The SPI object
+ * @param data The reply, must stay valid until its frame ends
+ * @param len  Number of bytes
+ */
+void spi_slave_reply(spi_t *obj, const uint8_t *data, uint16_t len)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    spiobj->slave_reply_len = len;
+    spiobj->slave_reply = (len > 0U) ? data : NULL;
+    __set_PRIMASK(primask);
+}
+
+/** Stop slave mode, the SPI itself is released by spi_free
+ *
+ * @param obj The SPI object
+ */
+static void spi_slave_end(spi_t *obj)
+{
+    struct spi_s *spiobj = SPI_S(obj);
+    uint8_t index = spi_dma_slot(spiobj->spi);
+
+    if ((index >= SPI_DMA_NUM) || (spi_slave_obj[index] != obj)) {
+        return;
     }
+    gpio_interrupt_disable(GD_PIN_GET(spiobj->pin_ssel));
+    spi_dma_disable(spiobj->spi, SPI_DMA_TRANSMIT);
+    spi_dma_disable(spiobj->spi, SPI_DMA_RECEIVE);
+    spi_slave_obj[index] = NULL;
 }
 
 #ifdef __cplusplus
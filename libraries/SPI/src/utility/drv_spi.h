@@ -33,6 +33,7 @@ OF SUCH DAMAGE.
 #include "PinNames.h"
 #include "PeripheralPins.h"
 #include "PeripheralNames.h"
+#include "dma.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +56,14 @@ extern "C" {
 #define SPI_CLOCK_DIV128  ((uint32_t)128)
 #define SPI_CLOCK_DIV256  ((uint32_t)256)
 
+/* block transfers of at least this many bytes go through DMA when the channels are free */
+#ifndef SPI_DMA_THRESHOLD
+#define SPI_DMA_THRESHOLD 16
+#endif
+
+typedef void (*spi_dma_callback_t)(void *param);
+typedef void (*spi_slave_callback_t)(void *param, uint8_t *frame, uint16_t len);
+
 struct spi_s {
     spi_parameter_struct spi_struct;
     SPIName spi;
@@ -62,15 +71,45 @@ struct spi_s {
     PinName pin_mosi;
     PinName pin_sclk;
     PinName pin_ssel;
+    /* DMA block transfers */
+    uint8_t dma;
+    uint8_t dma_index;
+    uint8_t dma_width;
+    volatile uint8_t dma_busy;
+    uint16_t dma_fill;
+    uint16_t dma_sink;
+    spi_dma_callback_t dma_callback;
+    void *dma_param;
+    /* slave mode */
+    uint8_t *slave_buffer;
+    uint16_t slave_size;
+    uint8_t slave_half;
+    const uint8_t *volatile slave_reply;
+    uint16_t slave_reply_len;
+    spi_slave_callback_t slave_callback;
+    void *slave_param;
 };
 
 typedef struct spi_s spi_t;
 
-void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian);
-uint32_t spi_master_write(spi_t *obj, uint8_t value);
-void spi_master_block_write(spi_t *obj, uint8_t *tx_buffer, uint8_t *rx_buffer, uint16_t len);
+void spi_begin(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian, uint8_t frame_bits);
+void spi_update(spi_t *obj, uint32_t speed, uint8_t mode, uint8_t endian, uint8_t frame_bits);
+void spi_frame_bits(spi_t *obj, uint8_t frame_bits);
+uint32_t spi_master_write(spi_t *obj, uint16_t value);
+int spi_master_block_write(spi_t *obj, uint8_t *tx_buffer, uint8_t *rx_buffer, uint16_t len);
+int spi_master_block_write16(spi_t *obj, uint16_t *tx_buffer, uint16_t *rx_buffer, uint16_t len);
+void spi_master_block_send(spi_t *obj, const uint8_t *tx_buffer, uint16_t len);
+void spi_master_block_send16(spi_t *obj, const uint16_t *tx_buffer, uint16_t len);
 uint32_t dev_spi_clock_source_frequency_get(spi_t *obj);
 void spi_free(spi_t *obj);
+uint8_t spi_dma_start(spi_t *obj);
+void spi_dma_stop(spi_t *obj);
+uint8_t spi_dma_transfer(spi_t *obj, const void *tx_buffer, void *rx_buffer, uint16_t len,
+                         spi_dma_callback_t callback, void *param);
+void spi_dma_wait(spi_t *obj);
+uint8_t spi_slave_begin(spi_t *obj, uint8_t mode, uint8_t endian, uint8_t *buffers, uint16_t frame_size,
+                        spi_slave_callback_t callback, void *param);
+void spi_slave_reply(spi_t *obj, const uint8_t *data, uint16_t len);
 
 #ifdef __cplusplus
 }
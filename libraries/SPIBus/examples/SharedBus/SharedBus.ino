@@ -0,0 +1,70 @@
+/*
+  SharedBus
+
+  Two devices on SPI: a sensor polled every 10 ms from loop() and a flash
+  chip whose status register is read in the same queue. Neither caller
+  waits for the bus, the transactions run back to back from the SPI
+  interrupt with chip select handled by SPIBus.
+*/
+
+#include <SPIBus.h>
+
+#define SENSOR_CS 10
+#define FLASH_CS  9
+
+SPIBus bus(SPI);
+int sensor, flash;
+
+// sensor: one read command followed by six data bytes under one chip select
+uint8_t sensor_cmd[1] = {0x80 | 0x28};
+uint8_t sensor_data[6];
+SPIBusTransfer sensor_read = {sensor_data, sensor_data, sizeof(sensor_data), NULL};
+SPIBusTransfer sensor_addr = {sensor_cmd, NULL, sizeof(sensor_cmd), &sensor_read};
+SPIBusTransaction sensor_job;
+
+// flash: read status register 1
+const uint8_t flash_cmd[2] = {0x05, 0x00};
+uint8_t flash_reply[2];
+SPIBusTransfer flash_status = {flash_cmd, flash_reply, sizeof(flash_reply), NULL};
+SPIBusTransaction flash_job;
+
+volatile uint32_t samples = 0;
+
+void sensorDone(SPIBusTransaction *transaction)
+{
+    (void)transaction;
+    samples++;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    bus.begin();
+    sensor = bus.addDevice(SENSOR_CS, SPISettings(8000000, MSBFIRST, SPI_MODE3));
+    flash = bus.addDevice(FLASH_CS, SPISettings(20000000, MSBFIRST, SPI_MODE0));
+
+    sensor_job.device = sensor;
+    sensor_job.transfers = &sensor_addr;
+    sensor_job.done = sensorDone;
+    flash_job.device = flash;
+    flash_job.transfers = &flash_status;
+}
+
+void loop()
+{
+    static uint32_t last_poll, last_print;
+
+    if (millis() - last_poll >= 10) {
+        last_poll = millis();
+        bus.submit(sensor_job);
+        bus.submit(flash_job);
+    }
+    if (millis() - last_print >= 1000) {
+        last_print = millis();
+        bus.wait(flash_job);
+        Serial.print("samples ");
+        Serial.print(samples);
+        Serial.print(" flash status 0x");
+        Serial.println(flash_reply[1], HEX);
+    }
+}
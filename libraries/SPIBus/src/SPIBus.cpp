@@ -0,0 +1,205 @@
+/*
+  SPIBus.cpp - Queued transactions for devices sharing an SPI bus
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SPIBus.h"
+
+// transferAsync() callbacks carry no argument, one trampoline per bus
+static SPIBus *bus_port[SPI_BUS_MAX];
+
+template <unsigned n>
+static void bus_complete_irq(void)
+{
+    if (bus_port[n] != NULL) {
+        bus_port[n]->_complete();
+    }
+}
+
+static void (*const bus_complete_irqs[SPI_BUS_MAX])(void) = {
+    bus_complete_irq<0>, bus_complete_irq<1>, bus_complete_irq<2>
+};
+
+SPIBus::SPIBus(SPIClass &spi)
+    : _spi(spi), _slot(-1), _device_count(0), _active_device(-1),
+      _head(NULL), _tail(NULL), _current(NULL), _phase(NULL), _pending(0),
+      _in_complete(false), _again(false)
+{
+}
+
+bool SPIBus::begin(void)
+{
+    if (_slot < 0) {
+        for (int i = 0; i < SPI_BUS_MAX; i++) {
+            if (bus_port[i] == NULL) {
+                bus_port[i] = this;
+                _slot = i;
+                break;
+            }
+        }
+        if (_slot < 0) {
+            return false;
+        }
+    }
+    _spi.begin();
+    _active_device = -1;
+    return true;
+}
+
+void SPIBus::end(void)
+{
+    if (_slot < 0) {
+        return;
+    }
+    while (_pending > 0);
+    bus_port[_slot] = NULL;
+    _slot = -1;
+}
+
+int SPIBus::addDevice(uint32_t csPin, SPISettings settings)
+{
+    Device *device;
+
+    if (_device_count >= SPI_BUS_DEVICES) {
+        return -1;
+    }
+    pinMode(csPin, OUTPUT);
+    digitalWrite(csPin, HIGH);
+    device = &_devices[_device_count];
+    device->settings = settings;
+    device->port = DIGITAL_PIN_TO_PORT(csPin);
+    device->mask = DIGITAL_PIN_TO_BIT_MASK(csPin);
+    return _device_count++;
+}
+
+bool SPIBus::submit(SPIBusTransaction &transaction)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    if ((_slot < 0) || (transaction.device >= _device_count)) {
+        return false;
+    }
+
+    __disable_irq();
+    if (transaction.busy) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+    transaction.busy = true;
+    transaction.queue_next = NULL;
+    if (_tail != NULL) {
+        _tail->queue_next = &transaction;
+    } else {
+        _head = &transaction;
+    }
+    _tail = &transaction;
+    _pending++;
+    __set_PRIMASK(primask);
+
+    _next();
+    return true;
+}
+
+void SPIBus::_complete(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    // a short transfer completes inside transferAsync(), so this can be
+    // entered again from _advance(): loop instead of recursing
+    __disable_irq();
+    if (_in_complete) {
+        _again = true;
+        __set_PRIMASK(primask);
+        return;
+    }
+    _in_complete = true;
+    __set_PRIMASK(primask);
+
+    for (;;) {
+        _advance();
+        __disable_irq();
+        if (!_again) {
+            _in_complete = false;
+            __set_PRIMASK(primask);
+            return;
+        }
+        _again = false;
+        __set_PRIMASK(primask);
+    }
+}
+
+void SPIBus::_advance(void)
+{
+    SPIBusTransaction *transaction = _current;
+    uint32_t primask = __get_PRIMASK();
+
+    if ((_phase != NULL) && (_phase->next != NULL)) {
+        _phase = _phase->next;
+        _launch();
+        return;
+    }
+
+    PORT_SET_REG(_devices[transaction->device].port) = _devices[transaction->device].mask;
+    __disable_irq();
+    _current = NULL;
+    _pending--;
+    __set_PRIMASK(primask);
+
+    transaction->busy = false;
+    if (transaction->done != NULL) {
+        transaction->done(transaction);
+    }
+    _next();
+}
+
+void SPIBus::_next(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    SPIBusTransaction *transaction;
+    Device *device;
+
+    __disable_irq();
+    if ((_current != NULL) || (_head == NULL)) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    transaction = _head;
+    _head = transaction->queue_next;
+    if (_head == NULL) {
+        _tail = NULL;
+    }
+    _current = transaction;
+    __set_PRIMASK(primask);
+
+    device = &_devices[transaction->device];
+    if (_active_device != transaction->device) {
+        _spi.beginTransaction(device->settings);
+        _active_device = transaction->device;
+    }
+    PORT_CLEAR_REG(device->port) = device->mask;
+    _phase = transaction->transfers;
+    _launch();
+}
+
+void SPIBus::_launch(void)
+{
+    if (_phase == NULL) {
+        // a transaction without transfers only pulses chip select
+        bus_complete_irqs[_slot]();
+        return;
+    }
+    _spi.transferAsync(_phase->tx, _phase->rx, _phase->count, bus_complete_irqs[_slot]);
+}
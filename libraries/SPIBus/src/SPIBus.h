@@ -0,0 +1,121 @@
+/*
+  SPIBus.h - Queued transactions for devices sharing an SPI bus
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SPIBus_h
+#define SPIBus_h
+
+#include <Arduino.h>
+#include <SPI.h>
+
+// Devices per bus
+#if !defined(SPI_BUS_DEVICES)
+#define SPI_BUS_DEVICES 8
+#endif
+// Buses that can run at the same time
+#define SPI_BUS_MAX 3
+
+// One phase of a transaction, e.g. a command followed by its data. A NULL tx
+// sends 0xFF, a NULL rx drops what comes back.
+struct SPIBusTransfer {
+    const void *tx;
+    void *rx;
+    size_t count;
+    // next phase of the same transaction, chip select stays low in between
+    SPIBusTransfer *next;
+};
+
+// Everything done under one chip select assertion. The caller owns the
+// memory, which must stay valid until busy is false again.
+struct SPIBusTransaction {
+    uint8_t device;
+    SPIBusTransfer *transfers;
+    // called once chip select is released, may submit again. This is the SPI
+    // DMA interrupt, or the context that ran the last phase without DMA (see
+    // SPIBus below), which may be the thread that called submit()
+    void (*done)(SPIBusTransaction *transaction);
+    void *user;
+    // true from submit() until just before done runs
+    volatile bool busy;
+    // queue link, owned by SPIBus
+    SPIBusTransaction *queue_next;
+};
+
+// Transactions are queued by submit() and run back to back from the SPI DMA
+// completion interrupt. Between transactions chip select and, when the devices
+// differ in them, the SPI settings are switched from that interrupt as well.
+// Once begin() has run, all traffic on the SPI must go through the bus.
+//
+// A phase only runs on DMA when it is at least SPI_DMA_THRESHOLD bytes long
+// and the SPI's DMA channels are free (e.g. not taken by a Serial port in DMA
+// mode). Any other phase is transferred synchronously by whoever starts it.
+// When submit() finds the bus idle it starts the transaction itself, so it
+// returns only after every phase up to the first DMA one, and the whole chain
+// when none of them uses DMA. The done callbacks of those transactions run in
+// the caller's context instead of the interrupt. Keep phases above the
+// threshold, or the DMA channels free, where callers must not wait.
+class SPIBus
+{
+    public:
+        SPIBus(SPIClass &spi = SPI);
+        bool begin(void);
+        void end(void);
+        // Register a device, returns its number or -1 if the table is full
+        int addDevice(uint32_t csPin, SPISettings settings);
+        // Queue a transaction, returns false if it is already queued or its device is unknown
+        bool submit(SPIBusTransaction &transaction);
+        // Transactions queued or running
+        uint16_t pending(void)
+        {
+            return _pending;
+        }
+        // Wait until the transaction is done
+        void wait(SPIBusTransaction &transaction)
+        {
+            while (transaction.busy);
+        }
+
+        // Interrupt side, called when a transfer is complete
+        void _complete(void);
+
+    private:
+        struct Device {
+            SPISettings settings;
+            uint32_t port;
+            uint16_t mask;
+        };
+
+        void _advance(void);
+        void _next(void);
+        void _launch(void);
+
+        SPIClass &_spi;
+        int8_t _slot;
+        Device _devices[SPI_BUS_DEVICES];
+        uint8_t _device_count;
+        int16_t _active_device;
+        // queued transactions, _current is the one on the bus
+        SPIBusTransaction *_head;
+        SPIBusTransaction *_tail;
+        SPIBusTransaction *_current;
+        SPIBusTransfer *_phase;
+        volatile uint16_t _pending;
+        bool _in_complete;
+        bool _again;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/*
+  FlashInfo
+
+  Reads the JEDEC ID of a W25Qxx flash on SPI, then erases the last sector
+  in the background while reading the first one, and checks a page written
+  to the erased sector.
+*/
+
+#include <SPIFlash.h>
+
+#define FLASH_CS 9
+
+SPIFlash flash(FLASH_CS);
+uint8_t page[SPIFLASH_PAGE_SIZE];
+uint8_t check[SPIFLASH_PAGE_SIZE];
+
+void setup()
+{
+    Serial.begin(115200);
+    if (flash.begin() != BD_ERROR_OK) {
+        Serial.println("no flash found");
+        return;
+    }
+    Serial.print("JEDEC ID 0x");
+    Serial.print(flash.jedecId(), HEX);
+    Serial.print(", ");
+    Serial.print(flash.size() / 1024);
+    Serial.println(" KB");
+
+    uint32_t last = flash.size() - SPIFLASH_SECTOR_SIZE;
+    uint32_t reads = 0;
+    flash.eraseAsync(last);
+    // reads suspend the erase while it runs
+    while (flash.busy()) {
+        flash.read(check, 0, sizeof(check));
+        reads++;
+    }
+    Serial.print(reads);
+    Serial.println(" reads during the erase");
+
+    for (unsigned i = 0; i < sizeof(page); i++) {
+        page[i] = i;
+    }
+    flash.program(page, last, sizeof(page));
+    flash.read(check, last, sizeof(check));
+    Serial.println(memcmp(page, check, sizeof(page)) == 0 ? "verify ok" : "verify failed");
+}
+
+void loop()
+{
+}
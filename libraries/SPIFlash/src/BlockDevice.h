@@ -0,0 +1,54 @@
+/*
+  BlockDevice.h - Interface of storage read, programmed and erased in blocks
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef BlockDevice_h
+#define BlockDevice_h
+
+#include <stdint.h>
+
+// Return values, 0 is success
+#define BD_ERROR_OK        0
+#define BD_ERROR_PARAMETER -1   // address or size out of range or misaligned
+#define BD_ERROR_DEVICE    -2   // no device answers
+#define BD_ERROR_TIMEOUT   -3   // the device stayed busy
+
+// Storage that is erased in units of eraseSize() before it can be programmed,
+// the shape file systems and loggers expect. Addresses are byte offsets.
+class BlockDevice
+{
+    public:
+        virtual ~BlockDevice() {}
+
+        virtual int read(void *buffer, uint32_t addr, uint32_t size) = 0;
+        // Only clears bits, the range must have been erased
+        virtual int program(const void *buffer, uint32_t addr, uint32_t size) = 0;
+        // addr and size are multiples of eraseSize()
+        virtual int erase(uint32_t addr, uint32_t size) = 0;
+        // Wait until everything started has reached the device
+        virtual int sync(void)
+        {
+            return BD_ERROR_OK;
+        }
+
+        virtual uint32_t readSize(void) const = 0;
+        virtual uint32_t programSize(void) const = 0;
+        virtual uint32_t eraseSize(void) const = 0;
+        virtual uint32_t size(void) const = 0;
+};
+
+#endif
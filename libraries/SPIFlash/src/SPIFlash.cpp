@@ -0,0 +1,446 @@
+/*
+  SPIFlash.cpp - W25Qxx SPI NOR flash block device
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SPIFlash.h"
+
+#define CMD_WRITE_ENABLE       0x06
+#define CMD_READ_STATUS1       0x05
+#define CMD_READ_STATUS2       0x35
+#define CMD_FAST_READ          0x0B
+#define CMD_FAST_READ4         0x0C
+#define CMD_PAGE_PROGRAM       0x02
+#define CMD_PAGE_PROGRAM4      0x12
+#define CMD_SECTOR_ERASE       0x20
+#define CMD_SECTOR_ERASE4      0x21
+#define CMD_BLOCK32_ERASE      0x52
+#define CMD_BLOCK64_ERASE      0xD8
+#define CMD_BLOCK64_ERASE4     0xDC
+#define CMD_ERASE_SUSPEND      0x75
+#define CMD_ERASE_RESUME       0x7A
+#define CMD_RELEASE_POWER_DOWN 0xAB
+#define CMD_JEDEC_ID           0x9F
+
+#define STATUS1_BUSY           0x01
+#define STATUS2_SUS            0x80
+
+// worst case times from the W25Q datasheets, in ms
+#define TIMEOUT_PAGE_PROGRAM   5
+#define TIMEOUT_SECTOR_ERASE   400
+#define TIMEOUT_BLOCK32_ERASE  1600
+#define TIMEOUT_BLOCK64_ERASE  2000
+
+#define BLOCK32_SIZE           0x8000UL
+#define BLOCK64_SIZE           0x10000UL
+
+SPIFlash::SPIFlash(uint32_t csPin, SPIClass &spi, uint32_t speed)
+    : _spi(spi), _settings(speed, MSBFIRST, SPI_MODE0), _cs(csPin), _id(0), _size(0),
+      _addr4(false), _erasing(false), _suspended(false), _resumed_at(0), _erase_timeout(0),
+      _erase_addr(0), _erase_size(0)
+{
+#if SPIFLASH_CACHE_LINES > 0
+    _clock = 0;
+    for (int i = 0; i < SPIFLASH_CACHE_LINES; i++) {
+        _lines[i].valid = false;
+    }
+#endif
+}
+
+int SPIFlash::begin(void)
+{
+    uint8_t id[3];
+
+    pinMode(_cs, OUTPUT);
+    digitalWrite(_cs, HIGH);
+    _spi.begin();
+
+    // a chip left in power down ignores everything else, tRES1 is 3 us
+    _simple(CMD_RELEASE_POWER_DOWN);
+    delayMicroseconds(5);
+
+    _select();
+    _spi.transfer(CMD_JEDEC_ID);
+    _spi.transfer(NULL, id, sizeof(id));
+    _deselect();
+    _id = ((uint32_t)id[0] << 16) | ((uint32_t)id[1] << 8) | id[2];
+    if ((id[0] == 0x00) || (id[0] == 0xFF) || (id[2] < 0x10) || (id[2] > 0x1F)) {
+        _size = 0;
+        return BD_ERROR_DEVICE;
+    }
+    _size = 1UL << id[2];
+    // above 16 MB the 4-byte address variants of the commands are used
+    _addr4 = (_size > 0x1000000UL);
+
+    // an erase suspended when the MCU was reset would otherwise never finish
+    _erasing = false;
+    _suspended = false;
+    if (_status(CMD_READ_STATUS2) & STATUS2_SUS) {
+        _simple(CMD_ERASE_RESUME);
+        _erasing = true;
+        _erase_timeout = TIMEOUT_BLOCK64_ERASE;
+        // whatever it was erasing is unknown, reads wait for it
+        _erase_addr = 0;
+        _erase_size = _size;
+        _resumed_at = micros();
+    }
+    _invalidate(0, _size);
+    return BD_ERROR_OK;
+}
+
+void SPIFlash::end(void)
+{
+    sync();
+}
+
+void SPIFlash::_select(void)
+{
+    _spi.beginTransaction(_settings);
+    digitalWrite(_cs, LOW);
+}
+
+void SPIFlash::_deselect(void)
+{
+    digitalWrite(_cs, HIGH);
+    _spi.endTransaction();
+}
+
+void SPIFlash::_command(uint8_t cmd, uint32_t addr, bool with_addr)
+{
+    uint8_t header[5];
+    size_t n = 0;
+
+    header[n++] = cmd;
+    if (with_addr) {
+        if (_addr4) {
+            header[n++] = addr >> 24;
+        }
+        header[n++] = addr >> 16;
+        header[n++] = addr >> 8;
+        header[n++] = addr;
+    }
+    _spi.writeBytes(header, n);
+}
+
+void SPIFlash::_simple(uint8_t cmd)
+{
+    _select();
+    _spi.transfer(cmd);
+    _deselect();
+}
+
+uint8_t SPIFlash::_status(uint8_t cmd)
+{
+    uint8_t status;
+
+    _select();
+    _spi.transfer(cmd);
+    status = _spi.transfer(0xFF);
+    _deselect();
+    return status;
+}
+
+int SPIFlash::_wait(uint32_t timeout_ms)
+{
+    uint32_t start = millis();
+
+    while (_status(CMD_READ_STATUS1) & STATUS1_BUSY) {
+        if (millis() - start > timeout_ms) {
+            return BD_ERROR_TIMEOUT;
+        }
+    }
+    return BD_ERROR_OK;
+}
+
+bool SPIFlash::busy(void)
+{
+    if (!_erasing) {
+        return false;
+    }
+    if (_status(CMD_READ_STATUS1) & STATUS1_BUSY) {
+        return true;
+    }
+    _erase_done();
+    return false;
+}
+
+void SPIFlash::_erase_done(void)
+{
+    // anything cached from the range while it was being erased is stale
+    _erasing = false;
+    _invalidate(_erase_addr, _erase_size);
+}
+
+int SPIFlash::_finish_erase(void)
+{
+    int ret;
+
+    if (!_erasing) {
+        return BD_ERROR_OK;
+    }
+    ret = _wait(_erase_timeout);
+    _erase_done();
+    return ret;
+}
+
+int SPIFlash::sync(void)
+{
+    return _finish_erase();
+}
+
+int SPIFlash::_suspend(void)
+{
+    uint32_t start;
+
+    if (!busy()) {
+        return BD_ERROR_OK;
+    }
+    // let the erase make progress since the last resume
+    while (micros() - _resumed_at < SPIFLASH_RESUME_US);
+
+    _simple(CMD_ERASE_SUSPEND);
+    // tSUS is at most 20 us, the erase may also just have finished
+    start = micros();
+    while (!(_status(CMD_READ_STATUS2) & STATUS2_SUS)) {
+        if (!(_status(CMD_READ_STATUS1) & STATUS1_BUSY)) {
+            _erase_done();
+            return BD_ERROR_OK;
+        }
+        if (micros() - start > 100) {
+            // still erasing: do not read, and cancel a suspend that lands late
+            _resume();
+            return BD_ERROR_TIMEOUT;
+        }
+    }
+    _suspended = true;
+    return BD_ERROR_OK;
+}
+
+void SPIFlash::_resume(void)
+{
+    _simple(CMD_ERASE_RESUME);
+    _suspended = false;
+    _resumed_at = micros();
+}
+
+void SPIFlash::_read_raw(void *buffer, uint32_t addr, uint32_t size)
+{
+    _select();
+    _command(_addr4 ? CMD_FAST_READ4 : CMD_FAST_READ, addr, true);
+    // one dummy byte, then the data streams in through DMA
+    _spi.transfer(0xFF);
+    _spi.transfer(NULL, buffer, size);
+    _deselect();
+}
+
+int SPIFlash::read(void *buffer, uint32_t addr, uint32_t size)
+{
+    uint8_t *dst = (uint8_t *)buffer;
+    int ret;
+
+    if ((addr >= _size) || (size > _size - addr)) {
+        return BD_ERROR_PARAMETER;
+    }
+    if (size == 0) {
+        return BD_ERROR_OK;
+    }
+    if (_erasing) {
+        // the range being erased reads as neither old nor erased data
+        if ((addr < _erase_addr + _erase_size) && (_erase_addr < addr + size)) {
+            ret = _finish_erase();
+        } else {
+            ret = _suspend();
+        }
+        if (ret != BD_ERROR_OK) {
+            return ret;
+        }
+    }
+
+#if SPIFLASH_CACHE_LINES > 0
+    while (size > 0) {
+        uint32_t base = addr & ~(uint32_t)(SPIFLASH_CACHE_LINE - 1);
+        uint32_t offset = addr - base;
+        uint32_t n;
+        int line = -1, oldest = 0;
+
+        // long aligned runs bypass the cache, they would only evict it
+        if ((offset == 0) && (size >= SPIFLASH_CACHE_LINE)) {
+            n = size & ~(uint32_t)(SPIFLASH_CACHE_LINE - 1);
+            _read_raw(dst, addr, n);
+        } else {
+            n = SPIFLASH_CACHE_LINE - offset;
+            if (n > size) {
+                n = size;
+            }
+            for (int i = 0; i < SPIFLASH_CACHE_LINES; i++) {
+                if (_lines[i].valid && (_lines[i].addr == base)) {
+                    line = i;
+                    break;
+                }
+                if (!_lines[i].valid || (_lines[oldest].valid && (_lines[i].used < _lines[oldest].used))) {
+                    oldest = i;
+                }
+            }
+            if (line < 0) {
+                // read ahead the whole line around the request
+                line = oldest;
+                _read_raw(_cache[line], base, SPIFLASH_CACHE_LINE);
+                _lines[line].addr = base;
+                _lines[line].valid = true;
+            }
+            _lines[line].used = ++_clock;
+            memcpy(dst, &_cache[line][offset], n);
+        }
+        dst += n;
+        addr += n;
+        size -= n;
+    }
+#else
+    _read_raw(dst, addr, size);
+#endif
+
+    if (_suspended) {
+        _resume();
+    }
+    return BD_ERROR_OK;
+}
+
+int SPIFlash::program(const void *buffer, uint32_t addr, uint32_t size)
+{
+    const uint8_t *src = (const uint8_t *)buffer;
+    uint32_t n;
+    int ret;
+
+    if ((addr >= _size) || (size > _size - addr)) {
+        return BD_ERROR_PARAMETER;
+    }
+    ret = _finish_erase();
+    if (ret != BD_ERROR_OK) {
+        return ret;
+    }
+    _invalidate(addr, size);
+
+    while (size > 0) {
+        // a page program wraps around inside its page, so never cross one
+        n = SPIFLASH_PAGE_SIZE - (addr % SPIFLASH_PAGE_SIZE);
+        if (n > size) {
+            n = size;
+        }
+        _simple(CMD_WRITE_ENABLE);
+        _select();
+        _command(_addr4 ? CMD_PAGE_PROGRAM4 : CMD_PAGE_PROGRAM, addr, true);
+        _spi.writeBytes(src, n);
+        _deselect();
+        ret = _wait(TIMEOUT_PAGE_PROGRAM);
+        if (ret != BD_ERROR_OK) {
+            return ret;
+        }
+        src += n;
+        addr += n;
+        size -= n;
+    }
+    return BD_ERROR_OK;
+}
+
+int SPIFlash::erase(uint32_t addr, uint32_t size)
+{
+    uint8_t cmd;
+    uint32_t n, timeout;
+    int ret;
+
+    if ((addr % SPIFLASH_SECTOR_SIZE) || (size % SPIFLASH_SECTOR_SIZE) ||
+            (addr >= _size) || (size > _size - addr)) {
+        return BD_ERROR_PARAMETER;
+    }
+    ret = _finish_erase();
+    if (ret != BD_ERROR_OK) {
+        return ret;
+    }
+    _invalidate(addr, size);
+
+    while (size > 0) {
+        if (((addr % BLOCK64_SIZE) == 0) && (size >= BLOCK64_SIZE)) {
+            cmd = _addr4 ? CMD_BLOCK64_ERASE4 : CMD_BLOCK64_ERASE;
+            n = BLOCK64_SIZE;
+            timeout = TIMEOUT_BLOCK64_ERASE;
+        } else if (!_addr4 && ((addr % BLOCK32_SIZE) == 0) && (size >= BLOCK32_SIZE)) {
+            // there is no 4-byte address variant of the 32 KB erase
+            cmd = CMD_BLOCK32_ERASE;
+            n = BLOCK32_SIZE;
+            timeout = TIMEOUT_BLOCK32_ERASE;
+        } else {
+            cmd = _addr4 ? CMD_SECTOR_ERASE4 : CMD_SECTOR_ERASE;
+            n = SPIFLASH_SECTOR_SIZE;
+            timeout = TIMEOUT_SECTOR_ERASE;
+        }
+        _simple(CMD_WRITE_ENABLE);
+        _select();
+        _command(cmd, addr, true);
+        _deselect();
+        ret = _wait(timeout);
+        if (ret != BD_ERROR_OK) {
+            return ret;
+        }
+        addr += n;
+        size -= n;
+    }
+    return BD_ERROR_OK;
+}
+
+int SPIFlash::eraseAsync(uint32_t addr, bool block)
+{
+    uint32_t n = block ? BLOCK64_SIZE : SPIFLASH_SECTOR_SIZE;
+    int ret;
+
+    if ((addr % n) || (addr >= _size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    ret = _finish_erase();
+    if (ret != BD_ERROR_OK) {
+        return ret;
+    }
+    _invalidate(addr, n);
+
+    _simple(CMD_WRITE_ENABLE);
+    _select();
+    if (block) {
+        _command(_addr4 ? CMD_BLOCK64_ERASE4 : CMD_BLOCK64_ERASE, addr, true);
+    } else {
+        _command(_addr4 ? CMD_SECTOR_ERASE4 : CMD_SECTOR_ERASE, addr, true);
+    }
+    _deselect();
+    _erasing = true;
+    _erase_addr = addr;
+    _erase_size = n;
+    _erase_timeout = block ? TIMEOUT_BLOCK64_ERASE : TIMEOUT_SECTOR_ERASE;
+    // the first suspend may come right away
+    _resumed_at = micros() - SPIFLASH_RESUME_US;
+    return BD_ERROR_OK;
+}
+
+void SPIFlash::_invalidate(uint32_t addr, uint32_t size)
+{
+#if SPIFLASH_CACHE_LINES > 0
+    for (int i = 0; i < SPIFLASH_CACHE_LINES; i++) {
+        if ((_lines[i].addr < addr + size) && (_lines[i].addr + SPIFLASH_CACHE_LINE > addr)) {
+            _lines[i].valid = false;
+        }
+    }
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
@@ -0,0 +1,129 @@
+/*
+  SPIFlash.h - W25Qxx SPI NOR flash block device
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SPIFlash_h
+#define SPIFlash_h
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "BlockDevice.h"
+
+// Read cache: lines of SPIFLASH_CACHE_LINE bytes, least recently used one is
+// refilled. SPIFLASH_CACHE_LINES 0 turns the cache off.
+#if !defined(SPIFLASH_CACHE_LINES)
+#define SPIFLASH_CACHE_LINES 4
+#endif
+#if !defined(SPIFLASH_CACHE_LINE)
+#define SPIFLASH_CACHE_LINE  512
+#endif
+// Least time an erase runs after a resume before a read may suspend it again,
+// so a stream of reads cannot hold it off forever
+#if !defined(SPIFLASH_RESUME_US)
+#define SPIFLASH_RESUME_US   200
+#endif
+
+#define SPIFLASH_PAGE_SIZE   256
+#define SPIFLASH_SECTOR_SIZE 4096
+
+class SPIFlash : public BlockDevice
+{
+    public:
+        SPIFlash(uint32_t csPin, SPIClass &spi = SPI, uint32_t speed = 40000000);
+
+        // Wake the chip and read its JEDEC ID, returns BD_ERROR_DEVICE if none answers
+        int begin(void);
+        void end(void);
+        // Manufacturer, memory type and capacity bytes, e.g. 0xEF4018 for a W25Q128
+        uint32_t jedecId(void) const
+        {
+            return _id;
+        }
+
+        // Reads that miss the cache are fast reads through SPI DMA. A read
+        // during an erase suspends the erase for its duration, or waits for
+        // it to finish if it overlaps the range being erased.
+        int read(void *buffer, uint32_t addr, uint32_t size);
+        // Split at page boundaries, one page program command per page
+        int program(const void *buffer, uint32_t addr, uint32_t size);
+        // Uses 64 KB and 32 KB block erases where the range allows, returns when done
+        int erase(uint32_t addr, uint32_t size);
+        // Start erasing the 4 KB sector (or the 64 KB block when block is true)
+        // at addr and return at once; reads outside it stay possible,
+        // program() and erase() wait for it
+        int eraseAsync(uint32_t addr, bool block = false);
+        bool busy(void);
+        int sync(void);
+
+        uint32_t readSize(void) const
+        {
+            return 1;
+        }
+        uint32_t programSize(void) const
+        {
+            return 1;
+        }
+        uint32_t eraseSize(void) const
+        {
+            return SPIFLASH_SECTOR_SIZE;
+        }
+        uint32_t size(void) const
+        {
+            return _size;
+        }
+
+    private:
+        void _select(void);
+        void _deselect(void);
+        void _command(uint8_t cmd, uint32_t addr, bool with_addr);
+        uint8_t _status(uint8_t cmd);
+        void _simple(uint8_t cmd);
+        int _wait(uint32_t timeout_ms);
+        int _finish_erase(void);
+        void _erase_done(void);
+        int _suspend(void);
+        void _resume(void);
+        void _read_raw(void *buffer, uint32_t addr, uint32_t size);
+        void _invalidate(uint32_t addr, uint32_t size);
+
+        SPIClass &_spi;
+        SPISettings _settings;
+        uint32_t _cs;
+        uint32_t _id;
+        uint32_t _size;
+        bool _addr4;
+        // erase started by eraseAsync() and not seen finished yet
+        bool _erasing;
+        bool _suspended;
+        uint32_t _resumed_at;
+        uint32_t _erase_timeout;
+        // range of the running erase, dropped from the cache again once it ends
+        uint32_t _erase_addr;
+        uint32_t _erase_size;
+#if SPIFLASH_CACHE_LINES > 0
+        struct Line {
+            uint32_t addr;
+            uint32_t used;
+            bool valid;
+        };
+        Line _lines[SPIFLASH_CACHE_LINES];
+        uint8_t _cache[SPIFLASH_CACHE_LINES][SPIFLASH_CACHE_LINE];
+        uint32_t _clock;
+#endif
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*
+  LookupTable
+
+  Maps an APS6404L PSRAM through the SQPI, fills a 64 KB sine table in it
+  and then reads entries straight from the mapped memory, the way a table
+  kept in external flash would be read.
+
+  The SQPI signals are on fixed pins, set the ones below to the SQPI_CLK,
+  SQPI_CSN and SQPI_D0..D3 pins in the datasheet of your package.
+*/
+
+#include <SQPI.h>
+
+#define SQPI_CLK_PIN PB13
+#define SQPI_CS_PIN  PB12
+#define SQPI_D0_PIN  PB15
+#define SQPI_D1_PIN  PB14
+#define SQPI_D2_PIN  PB11
+#define SQPI_D3_PIN  PB10
+
+#define ENTRIES 32768
+
+SQPIClass sqpi(SQPI_CLK_PIN, SQPI_CS_PIN, SQPI_D0_PIN, SQPI_D1_PIN, SQPI_D2_PIN, SQPI_D3_PIN);
+
+void setup()
+{
+    Serial.begin(115200);
+    if (!sqpi.begin(SQPI_PSRAM)) {
+        Serial.println("no PSRAM found");
+        return;
+    }
+    Serial.print("PSRAM ID 0x");
+    Serial.println(sqpi.id(), HEX);
+
+    int16_t *table = (int16_t *)sqpi.data();
+    for (uint32_t i = 0; i < ENTRIES; i++) {
+        table[i] = (int16_t)(32767 * sin(2 * PI * i / ENTRIES));
+    }
+
+    uint32_t start = micros();
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < ENTRIES; i += 7) {
+        sum += table[i];
+    }
+    Serial.print("sum ");
+    Serial.print(sum);
+    Serial.print(" in ");
+    Serial.print(micros() - start);
+    Serial.println(" us");
+}
+
+void loop()
+{
+}
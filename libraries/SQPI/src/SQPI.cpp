@@ -0,0 +1,263 @@
+/*
+  SQPI.cpp - Memory mapped quad SPI flash and PSRAM on GD32E50x
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SQPI.h"
+#include "pinmap.h"
+
+#define CMD_WRITE_ENABLE       0x06
+#define CMD_READ_STATUS1       0x05
+#define CMD_READ_STATUS2       0x35
+#define CMD_WRITE_STATUS       0x01
+#define CMD_RELEASE_POWER_DOWN 0xAB
+#define CMD_JEDEC_ID           0x9F
+#define CMD_QUAD_OUTPUT_READ   0x6B
+#define CMD_QUAD_READ          0xEB
+#define CMD_QUAD_WRITE         0x38
+#define CMD_RESET_ENABLE       0x66
+#define CMD_RESET              0x99
+
+#define STATUS1_BUSY           0x01
+#define STATUS2_QE             0x02
+
+// 0x6B: eight dummy clocks, 0xEB on PSRAM: six wait cycles at quad rate
+#define FLASH_READ_WAIT        8
+#define PSRAM_READ_WAIT        6
+
+#define SQPI_MAPPED_MAX        0x1000000UL
+#define PSRAM_SIZE             0x800000UL
+
+static void sqpi_pin_write(PinName pin, bool high)
+{
+    uint32_t gpio = gpio_clock_enable(GD_PORT_GET(pin));
+
+    if (high) {
+        gpio_bit_set(gpio, 1U << GD_PIN_GET(pin));
+    } else {
+        gpio_bit_reset(gpio, 1U << GD_PIN_GET(pin));
+    }
+}
+
+static bool sqpi_pin_read(PinName pin)
+{
+    uint32_t gpio = gpio_clock_enable(GD_PORT_GET(pin));
+
+    return gpio_input_bit_get(gpio, 1U << GD_PIN_GET(pin)) != RESET;
+}
+
+SQPIClass::SQPIClass(uint32_t clk, uint32_t cs, uint32_t d0, uint32_t d1, uint32_t d2, uint32_t d3)
+    : _clk(DIGITAL_TO_PINNAME(clk)), _cs(DIGITAL_TO_PINNAME(cs)),
+      _d{DIGITAL_TO_PINNAME(d0), DIGITAL_TO_PINNAME(d1), DIGITAL_TO_PINNAME(d2), DIGITAL_TO_PINNAME(d3)},
+      _id(0), _size(0)
+{
+}
+
+void SQPIClass::_pins_gpio(void)
+{
+    // plain SPI: D0 is MOSI, D1 is MISO, WP# and HOLD# are held high
+    sqpi_pin_write(_cs, true);
+    pin_function(_cs, GD_PIN_FUNCTION1(PIN_MODE_OUT_PP, 0));
+    sqpi_pin_write(_clk, false);
+    pin_function(_clk, GD_PIN_FUNCTION1(PIN_MODE_OUT_PP, 0));
+    pin_function(_d[0], GD_PIN_FUNCTION1(PIN_MODE_OUT_PP, 0));
+    pin_function(_d[1], GD_PIN_FUNCTION1(PIN_MODE_IN_FLOATING, 0));
+    sqpi_pin_write(_d[2], true);
+    pin_function(_d[2], GD_PIN_FUNCTION1(PIN_MODE_OUT_PP, 0));
+    sqpi_pin_write(_d[3], true);
+    pin_function(_d[3], GD_PIN_FUNCTION1(PIN_MODE_OUT_PP, 0));
+}
+
+void SQPIClass::_pins_sqpi(void)
+{
+    pin_function(_clk, GD_PIN_FUNCTION1(PIN_MODE_AF_PP, 0));
+    pin_function(_cs, GD_PIN_FUNCTION1(PIN_MODE_AF_PP, 0));
+    for (int i = 0; i < 4; i++) {
+        pin_function(_d[i], GD_PIN_FUNCTION1(PIN_MODE_AF_PP, 0));
+    }
+}
+
+void SQPIClass::_select(void)
+{
+    sqpi_pin_write(_cs, false);
+}
+
+void SQPIClass::_deselect(void)
+{
+    sqpi_pin_write(_cs, true);
+}
+
+uint8_t SQPIClass::_transfer(uint8_t out)
+{
+    uint8_t in = 0;
+
+    // mode 0, MSB first; only used while probing, speed does not matter
+    for (int bit = 7; bit >= 0; bit--) {
+        sqpi_pin_write(_d[0], (out >> bit) & 1);
+        sqpi_pin_write(_clk, true);
+        in = (in << 1) | (sqpi_pin_read(_d[1]) ? 1 : 0);
+        sqpi_pin_write(_clk, false);
+    }
+    return in;
+}
+
+void SQPIClass::_command(uint8_t cmd)
+{
+    _select();
+    _transfer(cmd);
+    _deselect();
+}
+
+bool SQPIClass::_begin_flash(void)
+{
+    uint8_t id[3], status1, status2;
+    uint32_t start;
+
+    _command(CMD_RELEASE_POWER_DOWN);
+    delayMicroseconds(5);
+
+    _select();
+    _transfer(CMD_JEDEC_ID);
+    for (int i = 0; i < 3; i++) {
+        id[i] = _transfer(0xFF);
+    }
+    _deselect();
+    _id = ((uint32_t)id[0] << 16) | ((uint32_t)id[1] << 8) | id[2];
+    if ((id[0] == 0x00) || (id[0] == 0xFF) || (id[2] < 0x10) || (id[2] > 0x1F)) {
+        return false;
+    }
+    _size = 1UL << id[2];
+
+    _select();
+    _transfer(CMD_READ_STATUS2);
+    status2 = _transfer(0xFF);
+    _deselect();
+    if (status2 & STATUS2_QE) {
+        return true;
+    }
+
+    // IO2 and IO3 are WP# and HOLD# until the quad enable bit is set, it is
+    // non-volatile so this only happens on the first run with a new chip
+    _select();
+    _transfer(CMD_READ_STATUS1);
+    status1 = _transfer(0xFF);
+    _deselect();
+    _command(CMD_WRITE_ENABLE);
+    _select();
+    _transfer(CMD_WRITE_STATUS);
+    _transfer(status1);
+    _transfer(status2 | STATUS2_QE);
+    _deselect();
+
+    start = millis();
+    do {
+        _select();
+        _transfer(CMD_READ_STATUS1);
+        status1 = _transfer(0xFF);
+        _deselect();
+        if (millis() - start > 50) {
+            return false;
+        }
+    } while (status1 & STATUS1_BUSY);
+
+    _select();
+    _transfer(CMD_READ_STATUS2);
+    status2 = _transfer(0xFF);
+    _deselect();
+    return (status2 & STATUS2_QE) != 0;
+}
+
+bool SQPIClass::_begin_psram(void)
+{
+    uint8_t mfid, kgd;
+
+    _command(CMD_RESET_ENABLE);
+    _command(CMD_RESET);
+    delayMicroseconds(50);
+
+    // read ID takes a 24-bit address before the ID bytes
+    _select();
+    _transfer(CMD_JEDEC_ID);
+    for (int i = 0; i < 3; i++) {
+        _transfer(0x00);
+    }
+    mfid = _transfer(0xFF);
+    kgd = _transfer(0xFF);
+    _deselect();
+    _id = ((uint32_t)mfid << 8) | kgd;
+    if ((mfid == 0x00) || (mfid == 0xFF)) {
+        return false;
+    }
+    _size = PSRAM_SIZE;
+    return true;
+}
+
+bool SQPIClass::begin(uint8_t type, uint32_t speed)
+{
+    sqpi_parameter_struct sqpi_struct;
+    uint32_t hclk, div;
+    bool found;
+
+    end();
+    _pins_gpio();
+    found = (type == SQPI_PSRAM) ? _begin_psram() : _begin_flash();
+    if (!found) {
+        _id = 0;
+        _size = 0;
+        return false;
+    }
+    if (_size > SQPI_MAPPED_MAX) {
+        _size = SQPI_MAPPED_MAX;
+    }
+
+    // SQPI clock is the AHB clock divided by div + 1
+    hclk = rcu_clock_freq_get(CK_AHB);
+    div = (speed > 0) ? (hclk + speed - 1) / speed : 64;
+    div = (div > 1) ? div - 1 : 1;
+    if (div > 0x3F) {
+        div = 0x3F;
+    }
+
+    rcu_periph_clock_enable(RCU_SQPI);
+    sqpi_deinit();
+    sqpi_struct_para_init(&sqpi_struct);
+    sqpi_struct.polarity = SQPI_SAMPLE_POLARITY_RISING;
+    sqpi_struct.id_length = SQPI_ID_LENGTH_32_BITS;
+    sqpi_struct.addr_bit = 24U;
+    sqpi_struct.clk_div = div;
+    sqpi_struct.cmd_bit = SQPI_CMDBIT_8_BITS;
+    sqpi_init(&sqpi_struct);
+
+    if (type == SQPI_PSRAM) {
+        sqpi_read_command_config(SQPI_MODE_SQQ, PSRAM_READ_WAIT, CMD_QUAD_READ);
+        sqpi_write_command_config(SQPI_MODE_SQQ, 0, CMD_QUAD_WRITE);
+    } else {
+        sqpi_read_command_config(SQPI_MODE_SSQ, FLASH_READ_WAIT, CMD_QUAD_OUTPUT_READ);
+    }
+    _pins_sqpi();
+    return true;
+}
+
+void SQPIClass::end(void)
+{
+    if (_size == 0) {
+        return;
+    }
+    sqpi_deinit();
+    rcu_periph_clock_disable(RCU_SQPI);
+    _pins_gpio();
+    _size = 0;
+}
@@ -0,0 +1,86 @@
+/*
+  SQPI.h - Memory mapped quad SPI flash and PSRAM on GD32E50x
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SQPI_h
+#define SQPI_h
+
+#include <Arduino.h>
+
+#if !defined(GD32E50X)
+#error "SQPI is only available on GD32E50x"
+#endif
+
+// Where the external memory appears once begin() has run
+#define SQPI_MEMORY_BASE 0xB0000000UL
+
+// Kind of chip behind the SQPI
+#define SQPI_FLASH 0    // W25Qxx and compatible NOR flash, read only
+#define SQPI_PSRAM 1    // APS6404L / ESP-PSRAM64 and compatible, read and write
+
+// The controller issues one command per AHB access: flash is read with quad
+// output fast read (0x6B, single line command and address, four line data),
+// PSRAM with quad fast read (0xEB) and written with quad write (0x38). Only
+// 24 address bits are sent, so at most the first 16 MB are mapped.
+//
+// begin() first talks to the chip over plain SPI on the same pins, bit-banged,
+// to read its ID and to set the quad enable bit of a flash that has it clear.
+class SQPIClass
+{
+    public:
+        SQPIClass(uint32_t clk, uint32_t cs, uint32_t d0, uint32_t d1, uint32_t d2, uint32_t d3);
+
+        // Returns false if no chip answers. speed is the highest SQPI clock,
+        // it is reached by dividing the AHB clock.
+        bool begin(uint8_t type = SQPI_FLASH, uint32_t speed = 40000000);
+        void end(void);
+
+        // JEDEC ID: manufacturer, type, capacity for flash; manufacturer and
+        // known good die byte for PSRAM
+        uint32_t id(void) const
+        {
+            return _id;
+        }
+        // Bytes mapped, 0 before begin(). PSRAM does not report its size, 8 MB is assumed.
+        uint32_t size(void) const
+        {
+            return _size;
+        }
+        // Start of the mapped memory, usable as a source of memcpy() and DMA
+        void *data(void) const
+        {
+            return (void *)SQPI_MEMORY_BASE;
+        }
+
+    private:
+        void _pins_gpio(void);
+        void _pins_sqpi(void);
+        void _select(void);
+        void _deselect(void);
+        uint8_t _transfer(uint8_t out);
+        void _command(uint8_t cmd);
+        bool _begin_flash(void);
+        bool _begin_psram(void);
+
+        PinName _clk;
+        PinName _cs;
+        PinName _d[4];
+        uint32_t _id;
+        uint32_t _size;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/*
+  PacketEcho
+
+  Receives COBS framed packets on Serial1 and sends each one back with its
+  bytes reversed. Packets with a bad CRC are counted and dropped before
+  loop() ever sees them.
+*/
+
+#include <SerialPacket.h>
+
+SerialPacket packets(Serial1, PACKET_COBS);
+
+void setup()
+{
+    Serial1.begin(115200);
+    packets.begin();
+}
+
+void loop()
+{
+    uint8_t data[SERIAL_PACKET_SIZE];
+
+    if (packets.available() < 0) {
+        return;
+    }
+    size_t size = packets.read(data, sizeof(data));
+    for (size_t i = 0; i < size / 2; i++) {
+        uint8_t c = data[i];
+        data[i] = data[size - 1 - i];
+        data[size - 1 - i] = c;
+    }
+    packets.send(data, size);
+}
@@ -0,0 +1,305 @@
+/*
+  SerialPacket.cpp - COBS / SLIP framed packets over HardwareSerial
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SerialPacket.h"
+
+#define SLIP_END     0xC0
+#define SLIP_ESC     0xDB
+#define SLIP_ESC_END 0xDC
+#define SLIP_ESC_ESC 0xDD
+
+static_assert((SERIAL_PACKET_QUEUE & (SERIAL_PACKET_QUEUE - 1)) == 0,
+              "SERIAL_PACKET_QUEUE must be a power of two");
+
+// onReceive() callbacks carry no argument, one trampoline per port
+static SerialPacket *packet_port[SERIAL_PACKET_PORTS];
+
+template <unsigned n>
+static void packet_receive_irq(void)
+{
+    if (packet_port[n] != NULL) {
+        packet_port[n]->_decode();
+    }
+}
+
+static void (*const packet_receive_irqs[SERIAL_PACKET_PORTS])(void) = {
+    packet_receive_irq<0>, packet_receive_irq<1>, packet_receive_irq<2>, packet_receive_irq<3>
+};
+
+SerialPacket::SerialPacket(HardwareSerial &port, uint8_t framing)
+    : _port(port), _framing(framing), _slot(-1), _callback(NULL),
+      _len(0), _code(0), _block(0), _escape(false), _overrun(false),
+      _q_head(0), _q_tail(0), _crc_errors(0), _dropped(0)
+{
+}
+
+bool SerialPacket::begin(void)
+{
+    if (_slot < 0) {
+        for (int i = 0; i < SERIAL_PACKET_PORTS; i++) {
+            if (packet_port[i] == NULL) {
+                packet_port[i] = this;
+                _slot = i;
+                break;
+            }
+        }
+        if (_slot < 0) {
+            return false;
+        }
+    }
+    rcu_periph_clock_enable(RCU_CRC);
+    _len = 0;
+    _code = 0;
+    _block = 0;
+    _escape = false;
+    _overrun = false;
+    _port.onReceive(packet_receive_irqs[_slot]);
+    return true;
+}
+
+void SerialPacket::end(void)
+{
+    if (_slot < 0) {
+        return;
+    }
+    _port.onReceive(NULL);
+    packet_port[_slot] = NULL;
+    _slot = -1;
+}
+
+uint32_t SerialPacket::crc(const uint8_t *data, size_t size)
+{
+    // the CRC unit is shared between send() and the interrupt side
+    uint32_t primask = __get_PRIMASK();
+    uint32_t word, result;
+
+    __disable_irq();
+    CRC_CTL |= CRC_CTL_RST;
+    for (; size >= 4; size -= 4, data += 4) {
+        CRC_DATA = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+    }
+    if (size > 0) {
+        word = 0;
+        for (unsigned i = 0; i < size; i++) {
+            word |= (uint32_t)data[i] << (24 - 8 * i);
+        }
+        CRC_DATA = word;
+    }
+    result = CRC_DATA;
+    __set_PRIMASK(primask);
+    return result;
+}
+
+void SerialPacket::_decode(void)
+{
+    const uint8_t *span;
+    size_t count;
+
+    // runs in the UART interrupt as bytes arrive, so the ring only has to
+    // hold what comes in between two interrupts, not a whole packet. The
+    // per-byte, idle line and DMA interrupts share one priority, so this is
+    // never entered again while it runs and the COBS/SLIP state stays whole.
+    while ((count = _port.readSpan(&span)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            _byte(span[i]);
+        }
+        _port.consume(count);
+    }
+}
+
+void SerialPacket::_byte(uint8_t c)
+{
+    if (_framing == PACKET_SLIP) {
+        if (c == SLIP_END) {
+            _end();
+            return;
+        }
+        if (c == SLIP_ESC) {
+            _escape = true;
+            return;
+        }
+        if (_escape) {
+            c = (c == SLIP_ESC_END) ? SLIP_END : (c == SLIP_ESC_ESC) ? SLIP_ESC : c;
+            _escape = false;
+        }
+    } else {
+        if (c == 0x00) {
+            _end();
+            return;
+        }
+        if (_code == 0) {
+            // a code byte, the block before it ends in a zero unless it was full
+            if ((_block != 0) && (_block != 0xFF)) {
+                _put(0x00);
+            }
+            _block = c;
+            _code = c - 1;
+            return;
+        }
+        _code--;
+    }
+    _put(c);
+}
+
+void SerialPacket::_put(uint8_t c)
+{
+    // with the queue full the slot being decoded into is still unread
+    if ((_len >= SERIAL_PACKET_SIZE) ||
+            ((_callback == NULL) && ((uint8_t)(_q_head - _q_tail) >= SERIAL_PACKET_QUEUE))) {
+        _overrun = true;
+        return;
+    }
+    _rx[_q_head & (SERIAL_PACKET_QUEUE - 1)][_len++] = c;
+}
+
+void SerialPacket::_end(void)
+{
+    uint8_t *buffer = _rx[_q_head & (SERIAL_PACKET_QUEUE - 1)];
+    uint16_t len = _len;
+    bool broken = _escape || (_code != 0);
+    bool overrun = _overrun;
+    uint32_t sum;
+
+    _len = 0;
+    _code = 0;
+    _block = 0;
+    _escape = false;
+    _overrun = false;
+    if (overrun) {
+        _dropped++;
+        return;
+    }
+    if ((len == 0) && !broken) {
+        // back to back delimiters
+        return;
+    }
+    if (broken || (len < 4)) {
+        _crc_errors++;
+        return;
+    }
+    len -= 4;
+    sum = buffer[len] | ((uint32_t)buffer[len + 1] << 8) | ((uint32_t)buffer[len + 2] << 16) |
+          ((uint32_t)buffer[len + 3] << 24);
+    if (crc(buffer, len) != sum) {
+        _crc_errors++;
+        return;
+    }
+    if (_callback != NULL) {
+        _callback(buffer, len);
+        return;
+    }
+    _rx_len[_q_head & (SERIAL_PACKET_QUEUE - 1)] = len;
+    __DMB();
+    _q_head++;
+}
+
+int SerialPacket::available(void)
+{
+    if (_q_head == _q_tail) {
+        return -1;
+    }
+    return _rx_len[_q_tail & (SERIAL_PACKET_QUEUE - 1)];
+}
+
+size_t SerialPacket::read(uint8_t *buffer, size_t size)
+{
+    uint8_t slot = _q_tail & (SERIAL_PACKET_QUEUE - 1);
+
+    if (_q_head == _q_tail) {
+        return 0;
+    }
+    if (size > _rx_len[slot]) {
+        size = _rx_len[slot];
+    }
+    memcpy(buffer, _rx[slot], size);
+    __DMB();
+    _q_tail++;
+    return size;
+}
+
+bool SerialPacket::send(const uint8_t *data, size_t size)
+{
+    uint8_t tail[4];
+    uint32_t sum;
+
+    if (size > SERIAL_PACKET_SIZE - 4) {
+        return false;
+    }
+    sum = crc(data, size);
+    tail[0] = sum;
+    tail[1] = sum >> 8;
+    tail[2] = sum >> 16;
+    tail[3] = sum >> 24;
+
+    if (_framing == PACKET_SLIP) {
+        // a leading END flushes any line noise at the receiver
+        _port.write(SLIP_END);
+        _slip(data, size);
+        _slip(tail, sizeof(tail));
+        _port.write(SLIP_END);
+        return true;
+    }
+
+    // COBS: each block is a code byte followed by up to 254 non-zero bytes
+    uint8_t block[255];
+    uint16_t n = 1;
+    for (size_t i = 0; i < size + sizeof(tail); i++) {
+        uint8_t c = (i < size) ? data[i] : tail[i - size];
+        if (c == 0x00) {
+            block[0] = n;
+            _port.write(block, n);
+            n = 1;
+            continue;
+        }
+        block[n++] = c;
+        if (n == 0xFF) {
+            block[0] = 0xFF;
+            _port.write(block, n);
+            n = 1;
+        }
+    }
+    block[0] = n;
+    _port.write(block, n);
+    _port.write((uint8_t)0x00);
+    return true;
+}
+
+void SerialPacket::_slip(const uint8_t *data, size_t size)
+{
+    uint8_t chunk[64];
+    size_t n = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        if (n > sizeof(chunk) - 2) {
+            _port.write(chunk, n);
+            n = 0;
+        }
+        if (data[i] == SLIP_END) {
+            chunk[n++] = SLIP_ESC;
+            chunk[n++] = SLIP_ESC_END;
+        } else if (data[i] == SLIP_ESC) {
+            chunk[n++] = SLIP_ESC;
+            chunk[n++] = SLIP_ESC_ESC;
+        } else {
+            chunk[n++] = data[i];
+        }
+    }
+    if (n > 0) {
+        _port.write(chunk, n);
+    }
+}
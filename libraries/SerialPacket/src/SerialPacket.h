@@ -0,0 +1,108 @@
+/*
+  SerialPacket.h - COBS / SLIP framed packets over HardwareSerial
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SerialPacket_h
+#define SerialPacket_h
+
+#include <Arduino.h>
+
+// Largest packet payload, plus room for the CRC
+#if !defined(SERIAL_PACKET_SIZE)
+#define SERIAL_PACKET_SIZE 256
+#endif
+// Verified packets waiting for read(), a power of two
+#if !defined(SERIAL_PACKET_QUEUE)
+#define SERIAL_PACKET_QUEUE 4
+#endif
+// Ports that can carry packets at the same time
+#define SERIAL_PACKET_PORTS 4
+
+// Framing of a packet on the wire
+#define PACKET_COBS 0   // consistent overhead byte stuffing, ends with 0x00
+#define PACKET_SLIP 1   // RFC 1055, starts and ends with 0xC0
+
+// On the wire a packet is the payload followed by its CRC-32, little endian,
+// then COBS or SLIP encoded. The CRC comes from the on-chip CRC unit: CRC-32/
+// MPEG-2 (polynomial 0x04C11DB7, init 0xFFFFFFFF, not reflected, no final
+// xor) over the payload padded with zero bytes to a multiple of four.
+//
+// Packets are decoded in the UART interrupt byte by byte as they arrive (with
+// DMA reception on half/full transfer and idle line), so a packet may be
+// larger than the port's receive ring. The decoder is the port's onReceive()
+// callback and the consumer of its receive ring: once begin() has run, do not
+// read() the HardwareSerial directly.
+class SerialPacket
+{
+    public:
+        SerialPacket(HardwareSerial &port, uint8_t framing = PACKET_COBS);
+        // Start decoding, call after the port's begin()
+        bool begin(void);
+        void end(void);
+        // Call callback from the UART interrupt for each verified packet
+        // instead of queueing it for read(). Passing NULL queues again.
+        void onPacket(void (*callback)(const uint8_t *data, size_t size))
+        {
+            _callback = callback;
+        }
+        // Payload size of the oldest queued packet, -1 if there is none
+        int available(void);
+        // Copy the oldest queued packet, bytes beyond size are discarded
+        size_t read(uint8_t *buffer, size_t size);
+        // Encode and write one packet, returns false if it is too large
+        bool send(const uint8_t *data, size_t size);
+        // Packets rejected for a bad CRC or bad framing
+        uint32_t crcErrors(void)
+        {
+            return _crc_errors;
+        }
+        // Packets lost because they were too large or the queue was full
+        uint32_t dropped(void)
+        {
+            return _dropped;
+        }
+
+        // Interrupt side, called through the receive callback
+        void _decode(void);
+        static uint32_t crc(const uint8_t *data, size_t size);
+
+    private:
+        void _byte(uint8_t c);
+        void _put(uint8_t c);
+        void _end(void);
+        void _slip(const uint8_t *data, size_t size);
+
+        HardwareSerial &_port;
+        uint8_t _framing;
+        int8_t _slot;
+        void (*_callback)(const uint8_t *data, size_t size);
+        // decoder state
+        uint16_t _len;
+        uint8_t _code;
+        uint8_t _block;
+        bool _escape;
+        bool _overrun;
+        // queued packets, _rx[_q_head] is being decoded into
+        uint8_t _rx[SERIAL_PACKET_QUEUE][SERIAL_PACKET_SIZE];
+        uint16_t _rx_len[SERIAL_PACKET_QUEUE];
+        volatile uint8_t _q_head;
+        volatile uint8_t _q_tail;
+        volatile uint32_t _crc_errors;
+        volatile uint32_t _dropped;
+};
+
+#endif
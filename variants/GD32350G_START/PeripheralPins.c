@@ -49,6 +49,18 @@ const int GD_GPIO_AF[] = {
     GPIO_AF_7,             /* 7 */
 };
 
+/* pin descriptions only reference the index in the array, provide
+ * convenience macros here.
+ */
+#define IND_GPIO_AF_0 0
+#define IND_GPIO_AF_1 1
+#define IND_GPIO_AF_2 2
+#define IND_GPIO_AF_3 3
+#define IND_GPIO_AF_4 4
+#define IND_GPIO_AF_5 5
+#define IND_GPIO_AF_6 6
+#define IND_GPIO_AF_7 7
+
 /* GPIO MODE */
 const int GD_GPIO_MODE[] = {
     GPIO_MODE_INPUT,             /* 0 */
@@ -177,20 +189,14 @@ const PinMap PinMap_UART_RX[] = {
 };
 
 const PinMap PinMap_UART_RTS[] = {
-    {PORTA_12, USART0, 7},
-    {PORTA_1,  USART1, 7},
-    // {PORTD_4,  USART1, 7 | (4 << 3)},   /* GPIO_USART1_RTS_REMAP */
-    // {PORTB_14, USART2, 7},
-    // {PORTD_12, USART2, 7 | (6 << 3)},   /* GPIO_USART2_RTS_FULL_REMAP */
+    {PORTA_12, USART0, GD_PIN_FUNCTION4(PIN_MODE_AF, GPIO_OTYPE_PP, PIN_PUPD_NONE, IND_GPIO_AF_1)}, /* USART0_RTS */
+    {PORTA_1,  USART1, GD_PIN_FUNCTION4(PIN_MODE_AF, GPIO_OTYPE_PP, PIN_PUPD_NONE, IND_GPIO_AF_1)}, /* USART1_RTS */
     {NC,    NC,    0}
 };
 
 const PinMap PinMap_UART_CTS[] = {
-    {PORTA_11, USART0, 7},
-    {PORTA_0,  USART1, 7},
-    // {PORTD_3,  USART1, 7 | (4 << 3)},   /* GPIO_USART1_CTS_REMAP */
-    // {PORTB_13, USART2, 7},
-    // {PORTD_11, USART2, 7 | (6 << 3)},   /* GPIO_USART2_CTS_FULL_REMAP */
+    {PORTA_11, USART0, GD_PIN_FUNCTION4(PIN_MODE_AF, GPIO_OTYPE_PP, PIN_PUPD_NONE, IND_GPIO_AF_1)}, /* USART0_CTS */
+    {PORTA_0,  USART1, GD_PIN_FUNCTION4(PIN_MODE_AF, GPIO_OTYPE_PP, PIN_PUPD_NONE, IND_GPIO_AF_1)}, /* USART1_CTS */
     {NC,    NC,    0}
 };
 
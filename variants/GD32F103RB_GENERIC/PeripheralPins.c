@@ -220,17 +220,17 @@ const PinMap PinMap_UART_RX[] = {
 
 /* UART_RTS PinMap */
 const PinMap PinMap_UART_RTS[] = {
-    {PORTA_1,       USART1, GPIO_MODE_AF_PP},      /* USART1_RTS */
-    {PORTA_12,      USART0, GPIO_MODE_AF_PP},      /* USART0_RTS */
-    {PORTB_14,      USART2, GPIO_MODE_AF_PP},      /* USART2_RTS */
+    {PORTA_1,       USART1, PIN_MODE_AF_PP},       /* USART1_RTS */
+    {PORTA_12,      USART0, PIN_MODE_AF_PP},       /* USART0_RTS */
+    {PORTB_14,      USART2, PIN_MODE_AF_PP},       /* USART2_RTS */
     {NC,   NC,    0}
 };
 
 /* UART_CTS PinMap */
 const PinMap PinMap_UART_CTS[] = {
-    {PORTA_0,       USART1, GPIO_MODE_AF_PP},      /* USART1_CTS */
-    {PORTA_11,      USART0, GPIO_MODE_AF_PP},      /* USART0_CTS */
-    {PORTB_13,      USART2, GPIO_MODE_AF_PP},      /* USART2_CTS */
+    {PORTA_0,       USART1, PIN_MODE_IN_FLOATING}, /* USART1_CTS */
+    {PORTA_11,      USART0, PIN_MODE_IN_FLOATING}, /* USART0_CTS */
+    {PORTB_13,      USART2, PIN_MODE_IN_FLOATING}, /* USART2_CTS */
     {NC,   NC,    0}
 };
 
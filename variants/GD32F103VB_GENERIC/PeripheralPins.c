@@ -219,18 +219,18 @@ const PinMap PinMap_UART_RX[] = {
 
 /* UART_RTS PinMap */
 const PinMap PinMap_UART_RTS[] = {
-    {PORTA_1,       USART1, GPIO_MODE_AF_PP},      /* USART1_RTS */
-    {PORTA_12,      USART0, GPIO_MODE_AF_PP},      /* USART0_RTS */
-    {PORTB_14,      USART2, GPIO_MODE_AF_PP},      /* USART2_RTS */
+    {PORTA_1,       USART1, PIN_MODE_AF_PP},       /* USART1_RTS */
+    {PORTA_12,      USART0, PIN_MODE_AF_PP},       /* USART0_RTS */
+    {PORTB_14,      USART2, PIN_MODE_AF_PP},       /* USART2_RTS */
     {PORTD_12,      USART2, GD_PIN_FUNCTION5(PIN_MODE_AF, PIN_OTYPE_PP, PIN_PUPD_PULLUP, USART2_FULL_REMAP)}, /* USART2_RTS */
     {NC,   NC,    0}
 };
 
 /* UART_CTS PinMap */
 const PinMap PinMap_UART_CTS[] = {
-    {PORTA_0,       USART1, GPIO_MODE_AF_PP},      /* USART1_CTS */
-    {PORTA_11,      USART0, GPIO_MODE_AF_PP},      /* USART0_CTS */
-    {PORTB_13,      USART2, GPIO_MODE_AF_PP},      /* USART2_CTS */
+    {PORTA_0,       USART1, PIN_MODE_IN_FLOATING}, /* USART1_CTS */
+    {PORTA_11,      USART0, PIN_MODE_IN_FLOATING}, /* USART0_CTS */
+    {PORTB_13,      USART2, PIN_MODE_IN_FLOATING}, /* USART2_CTS */
     {PORTD_3,       USART1, GD_PIN_FUNCTION5(PIN_MODE_AF, PIN_OTYPE_PP, PIN_PUPD_PULLUP, USART1_REMAP)}, /* USART1_CTS */
     {PORTD_11,      USART2, GD_PIN_FUNCTION5(PIN_MODE_AF, PIN_OTYPE_PP, PIN_PUPD_PULLUP, USART2_FULL_REMAP)}, /* USART2_CTS */
     {NC,   NC,    0}
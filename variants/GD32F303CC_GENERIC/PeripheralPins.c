@@ -284,11 +284,11 @@ const PinMap PinMap_UART_RTS[] = {
 };
 
 const PinMap PinMap_UART_CTS[] = {
-    {PORTA_11, USART0, 7},
-    {PORTA_0,  USART1, 7},
-    {PORTD_3,  USART1, 7 | (4 << 3)},   /* GPIO_USART1_CTS_REMAP */
-    {PORTB_13, USART2, 7},
-    {PORTD_11, USART2, 7 | (6 << 3)},   /* GPIO_USART2_CTS_FULL_REMAP */
+    {PORTA_11, USART0, 1},
+    {PORTA_0,  USART1, 1},
+    {PORTD_3,  USART1, 1 | (4 << 3)},   /* GPIO_USART1_CTS_REMAP */
+    {PORTB_13, USART2, 1},
+    {PORTD_11, USART2, 1 | (6 << 3)},   /* GPIO_USART2_CTS_FULL_REMAP */
     {NC,    NC,    0}
 };
 
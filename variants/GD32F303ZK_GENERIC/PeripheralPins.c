@@ -263,23 +263,21 @@ const PinMap PinMap_UART_RX[] = {
     {NC,   NC,    0}
 };
 
-/* UART_RTS PinMap */
+/* UART_RTS PinMap, the remapped USART1/USART2 pins on port D are left out:
+   GD_GPIO_REMAP has no entries for their remaps in this variant */
 const PinMap PinMap_UART_RTS[] = {
-    {PORTA_1,       USART1, GPIO_MODE_AF_PP},      /* USART1_RTS */
-    {PORTA_12,      USART0, GPIO_MODE_AF_PP},      /* USART0_RTS */
-    {PORTB_14,      USART2, GPIO_MODE_AF_PP},      /* USART2_RTS */
-    {PORTD_4,       USART1, GPIO_MODE_AF_PP},      /* USART1_RTS */
-    {PORTD_12,      USART2, GPIO_MODE_AF_PP},      /* USART2_RTS */
+    {PORTA_1,       USART1, PIN_MODE_AF_PP},       /* USART1_RTS */
+    {PORTA_12,      USART0, PIN_MODE_AF_PP},       /* USART0_RTS */
+    {PORTB_14,      USART2, PIN_MODE_AF_PP},       /* USART2_RTS */
     {NC,   NC,    0}
 };
 
-/* UART_CTS PinMap */
+/* UART_CTS PinMap, the remapped USART1/USART2 pins on port D are left out:
+   GD_GPIO_REMAP has no entries for their remaps in this variant */
 const PinMap PinMap_UART_CTS[] = {
-    {PORTA_0,       USART1, GPIO_MODE_AF_PP},      /* USART1_CTS */
-    {PORTA_11,      USART0, GPIO_MODE_AF_PP},      /* USART0_CTS */
-    {PORTB_13,      USART2, GPIO_MODE_AF_PP},      /* USART2_CTS */
-    {PORTD_3,       USART1, GPIO_MODE_AF_PP},      /* USART1_CTS */
-    {PORTD_11,      USART2, GPIO_MODE_AF_PP},      /* USART2_CTS */
+    {PORTA_0,       USART1, PIN_MODE_IN_FLOATING}, /* USART1_CTS */
+    {PORTA_11,      USART0, PIN_MODE_IN_FLOATING}, /* USART0_CTS */
+    {PORTB_13,      USART2, PIN_MODE_IN_FLOATING}, /* USART2_CTS */
     {NC,   NC,    0}
 };
 